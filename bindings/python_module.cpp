@@ -0,0 +1,168 @@
+#include "InProcessEnv.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// stonefish_rl_native: StonefishRL inside the Python process (EnvStonefishRL(..., transport="native")).
+// Physics runs with the GIL released, observations are written into a caller-owned float32 buffer.
+
+namespace py = pybind11;
+
+namespace {
+
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// Calls after close() raise instead of touching the released simulator
+const InProcessEnv& checked(const InProcessEnv& env) {
+    if (!env.isReady()) {
+        throw std::runtime_error("InProcessEnv is closed");
+    }
+    return env;
+}
+
+// Output buffer given by the caller (used as is, so it must be a writable contiguous float32 array),
+// or a new array of the observation size
+py::array_t<float> outputBuffer(const InProcessEnv& env, py::object out) {
+    checked(env);
+    if (out.is_none()) {
+        return py::array_t<float>(static_cast<py::ssize_t>(env.getObservationSize()));
+    }
+    if (!py::isinstance<py::array_t<float>>(out)) {
+        throw std::invalid_argument("out must be a float32 numpy array");
+    }
+    py::array array = py::reinterpret_borrow<py::array>(out);
+    if (!(array.flags() & py::array::c_style) || !array.writeable()) {
+        throw std::invalid_argument("out must be a writable C-contiguous array");
+    }
+    if (static_cast<size_t>(array.size()) < env.getObservationSize()) {
+        throw std::invalid_argument("out holds " + std::to_string(array.size()) + " values, "
+                                    + std::to_string(env.getObservationSize()) + " needed");
+    }
+    return py::reinterpret_borrow<py::array_t<float>>(out);
+}
+
+// View on the values written, the buffer itself when all of it was used
+py::array_t<float> written(py::array_t<float> buffer, size_t count) {
+    if (static_cast<size_t>(buffer.size()) == count) {
+        return buffer;
+    }
+    py::object view = buffer.attr("reshape")(-1)[py::slice(0, static_cast<py::ssize_t>(count), 1)];
+    return py::reinterpret_borrow<py::array_t<float>>(view);
+}
+
+py::object outcome(const InProcessEnv& env) {
+    if (!checked(env).hasOutcome()) {
+        return py::none();
+    }
+    const StepOutcome& o = env.getLastOutcome();
+    return py::make_tuple(o.reward, o.terminated, o.truncated);
+}
+
+py::object resetInfo(const InProcessEnv& env) {
+    const nlohmann::json& info = checked(env).getLastResetInfo();
+    if (info.is_null()) {
+        return py::none();
+    }
+    return py::module_::import("json").attr("loads")(info.dump());
+}
+
+}  // namespace
+
+
+PYBIND11_MODULE(stonefish_rl_native, m) {
+    m.doc() = "StonefishRL environment embedded in the Python process";
+
+    py::class_<InProcessEnv>(m, "InProcessEnv")
+        .def(py::init([](const std::string& scene_path, const std::string& resources_path,
+                         const std::string& observation_config_path, const std::string& action_config_path,
+                         double frequency) {
+                 auto env = std::make_unique<InProcessEnv>(scene_path, resources_path, observation_config_path,
+                                                           action_config_path, frequency);
+                 if (!env->isReady()) {
+                     throw std::runtime_error("StonefishRL could not be started in-process (see the log)");
+                 }
+                 return env;
+             }),
+             py::arg("scene_path"), py::arg("resources_path"), py::arg("observation_config_path"),
+             py::arg("action_config_path"), py::arg("frequency") = 200.0)
+        .def("close", &InProcessEnv::close, "Release the simulator, a new InProcessEnv may be created afterwards")
+        .def_property_readonly("closed", [](const InProcessEnv& env) { return !env.isReady(); })
+        .def_property_readonly("observation_size", [](const InProcessEnv& env) { return checked(env).getObservationSize(); })
+        .def_property_readonly("action_size", [](const InProcessEnv& env) { return checked(env).getActionSize(); })
+        .def_property_readonly("sim_time", [](InProcessEnv& env) {
+            checked(env);
+            return env.getSimulationTime();
+        })
+        .def_property_readonly("layout", [](const InProcessEnv& env) {
+            // Same dict as the HELLO reply
+            nlohmann::json layout = checked(env).describeLayout();
+            layout["status"] = "READY";
+            return py::module_::import("json").attr("loads")(layout.dump());
+        })
+        .def_property_readonly("outcome", &outcome,
+                               "(reward, terminated, truncated) of the last step, None without reward config")
+        .def_property_readonly("reset_info", &resetInfo, "Poses sampled for the last reset, None without reset config")
+        .def("reset", [](InProcessEnv& env, const std::string& payload, py::object out) {
+                 py::array_t<float> buffer = outputBuffer(env, out);
+                 float* data = buffer.mutable_data();
+                 size_t capacity = static_cast<size_t>(buffer.size());
+                 size_t count;
+                 {
+                     py::gil_scoped_release release;
+                     count = env.reset(payload, data, capacity);
+                 }
+                 return written(buffer, count);
+             },
+             py::arg("payload") = "", py::arg("out") = py::none(),
+             "Reset (payload as after 'RESET:'), returns the observation written into out")
+        .def("step", [](InProcessEnv& env, FloatArray actions, py::object out, unsigned int substeps) {
+                 if (static_cast<size_t>(actions.size()) != checked(env).getActionSize()) {
+                     throw std::invalid_argument("expected " + std::to_string(env.getActionSize()) + " actions, got "
+                                                 + std::to_string(actions.size()));
+                 }
+                 if (substeps > env.getMaxSubsteps()) {
+                     throw std::invalid_argument(std::to_string(substeps) + " substeps requested, max_substeps is "
+                                                 + std::to_string(env.getMaxSubsteps()));
+                 }
+                 py::array_t<float> buffer = outputBuffer(env, out);
+                 const float* action_data = actions.data();
+                 float* data = buffer.mutable_data();
+                 size_t capacity = static_cast<size_t>(buffer.size());
+                 size_t count;
+                 {
+                     py::gil_scoped_release release;
+                     count = env.step(action_data, static_cast<size_t>(actions.size()), substeps, data, capacity);
+                 }
+                 return written(buffer, count);
+             },
+             py::arg("actions"), py::arg("out") = py::none(), py::arg("substeps") = 0,
+             "Hold the actions for substeps physics steps (0 = action config default), returns the observation")
+        .def("snapshot", [](InProcessEnv& env, unsigned int slot) {
+                 checked(env);
+                 return env.saveSnapshot(slot);
+             },
+             py::arg("slot") = 0)
+        .def("restore", [](InProcessEnv& env, unsigned int slot, py::object out) -> py::object {
+                 py::array_t<float> buffer = outputBuffer(env, out);
+                 float* data = buffer.mutable_data();
+                 size_t capacity = static_cast<size_t>(buffer.size());
+                 size_t count;
+                 {
+                     py::gil_scoped_release release;
+                     count = env.restoreSnapshot(slot, data, capacity);
+                 }
+                 if (count == 0 && env.getObservationSize() > 0) {
+                     return py::none();
+                 }
+                 return written(buffer, count);
+             },
+             py::arg("slot") = 0, py::arg("out") = py::none())
+        .def("stats", [](InProcessEnv& env, bool reset) {
+                 checked(env);
+                 return py::module_::import("json").attr("loads")(env.stats(reset));
+             },
+             py::arg("reset") = false);
+}
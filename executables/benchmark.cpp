@@ -0,0 +1,663 @@
+#include "StonefishRL.h"
+#include "ConfigLoader.h"
+#include "SharedMemoryTransport.h"
+#include "CommonTypes.h"
+#include <zmq.hpp>
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <Stonefish/core/ConsoleSimulationApp.h>
+
+// Load generator for the StonefishRL protocol. Drives RESET/CMD cycles with synthetic actions
+// through every transport mode and writes steps/s, round-trip latencies and bytes per step to
+// a JSON file, either against a running StonefishRLTest (--connect) or a simulator started in-process.
+//
+//   StonefishRLBenchmark --connect tcp://localhost:5555 --act ACTION_CONFIG [options]
+//   StonefishRLBenchmark SCENE_PATH RESOURCES_PATH OBS_CONFIG_PATH ACTION_CONFIG_PATH [options]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkOptions {
+    std::string connect;                // endpoint of a running simulator (empty: start one in-process)
+    std::string endpoint = "tcp://127.0.0.1:*";
+    std::string scene_path;
+    std::string resources_path;
+    std::string obs_conf_path;
+    std::string action_conf_path;
+    bool async_server = false;
+    std::vector<std::string> modes = {"json", "binary", "frames", "shm", "async"};
+    unsigned int steps = 2000;
+    unsigned int warmup = 100;
+    unsigned int episode = 200;         // steps between resets (0 = only the initial reset)
+    unsigned int substeps = 0;          // 0 = action config default
+    unsigned int depth = 4;             // requests in flight in async mode
+    int timeout_ms = 10000;
+    double frequency = 200.0;
+    std::string output = "benchmark_results.json";
+    std::string label;
+    bool exit_server = false;           // send EXIT to a --connect server when done
+};
+
+struct ModeResult {
+    std::string mode;
+    std::string error;                  // empty: the run completed
+    std::string skipped;                // mode not available on this server
+    unsigned long long steps = 0;
+    unsigned long long resets = 0;
+    double elapsed_s = 0.0;             // measured steps only, resets excluded
+    std::vector<double> latency_us;
+    std::vector<double> reset_latency_us;
+    unsigned long long request_bytes = 0;
+    unsigned long long reply_bytes = 0;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+nlohmann::json latencySummary(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    nlohmann::json summary;
+    summary["count"] = samples.size();
+    summary["mean"] = samples.empty() ? 0.0 : sum / samples.size();
+    summary["p50"] = percentile(samples, 50.0);
+    summary["p90"] = percentile(samples, 90.0);
+    summary["p99"] = percentile(samples, 99.0);
+    summary["max"] = samples.empty() ? 0.0 : samples.back();
+    return summary;
+}
+
+// Sine per action index, so every step sends a different command
+void syntheticAction(unsigned long long step, std::vector<float>& action) {
+    for (size_t i = 0; i < action.size(); ++i) {
+        action[i] = static_cast<float>(std::sin(0.01 * step + i));
+    }
+}
+
+// One client socket with byte accounting. REQ for the lockstep modes, DEALER for pipelining
+class BenchmarkClient {
+public:
+    BenchmarkClient(zmq::context_t& context, const std::string& endpoint, bool dealer, int timeout_ms)
+        : socket_(context, dealer ? zmq::socket_type::dealer : zmq::socket_type::req) {
+        socket_.set(zmq::sockopt::linger, 0);
+        socket_.set(zmq::sockopt::rcvtimeo, timeout_ms);
+        socket_.connect(endpoint);
+    }
+
+    bool send(const void* data, size_t size) {
+        // A REQ socket that missed a reply can not send again
+        if (stalled_) return false;
+        if (control_doorbell_) {
+            control_doorbell_->notifyControl();
+        }
+        request_bytes_ += size;
+        zmq::message_t message(data, size);
+        return socket_.send(message, zmq::send_flags::none).has_value();
+    }
+
+    bool send(const std::string& str) { return send(str.data(), str.size()); }
+
+    bool receive(zmq::message_t& reply) {
+        if (!socket_.recv(reply, zmq::recv_flags::none)) {
+            stalled_ = true;
+            return false;
+        }
+        reply_bytes_ += reply.size();
+        return true;
+    }
+
+    bool request(const std::string& str, zmq::message_t& reply) {
+        return send(str) && receive(reply);
+    }
+
+    // Control replies are plain strings ("FORMAT OK", "SHM OK ...")
+    std::string requestString(const std::string& str) {
+        zmq::message_t reply;
+        return request(str, reply) ? reply.to_string() : "";
+    }
+
+    // While a shared memory segment is open the server only reads ZMQ when rung
+    void setControlDoorbell(SharedMemoryClient* shm) { control_doorbell_ = shm; }
+
+    void resetCounters() {
+        request_bytes_ = 0;
+        reply_bytes_ = 0;
+    }
+    unsigned long long getRequestBytes() const { return request_bytes_; }
+    unsigned long long getReplyBytes() const { return reply_bytes_; }
+
+private:
+    zmq::socket_t socket_;
+    unsigned long long request_bytes_ = 0;
+    unsigned long long reply_bytes_ = 0;
+    bool stalled_ = false;
+    SharedMemoryClient* control_doorbell_ = nullptr;
+};
+
+bool isBinaryObservation(const zmq::message_t& reply) {
+    if (reply.size() < sizeof(ObservationHeader)) return false;
+    uint32_t magic;
+    std::memcpy(&magic, reply.data(), sizeof(magic));
+    return magic == OBSERVATION_MAGIC;
+}
+
+bool isJsonObservation(const zmq::message_t& reply) {
+    return reply.size() > 0 && (static_cast<const char*>(reply.data())[0] == '{'
+                                || static_cast<const char*>(reply.data())[0] == '[');
+}
+
+class Benchmark {
+public:
+    Benchmark(const BenchmarkOptions& options, const std::string& endpoint, const nlohmann::json& layout)
+        : options_(options), endpoint_(endpoint), layout_(layout) {
+        action_size_ = layout_.value("action_size", 0u);
+        if (!options_.action_conf_path.empty()) {
+            ConfigLoader loader;
+            action_specs_ = loader.loadActionConfigFromFile(options_.action_conf_path).specs;
+        }
+    }
+
+    ModeResult run(const std::string& mode) {
+        ModeResult result;
+        result.mode = mode;
+        if (mode == "json" || mode == "binary") {
+            runStrings(mode == "binary", result);
+        } else if (mode == "frames") {
+            runFrames(result);
+        } else if (mode == "shm") {
+            runSharedMemory(result);
+        } else if (mode == "async") {
+            runAsync(result);
+        } else {
+            result.error = "unknown mode";
+        }
+        return result;
+    }
+
+private:
+    const BenchmarkOptions& options_;
+    std::string endpoint_;
+    nlohmann::json layout_;
+    size_t action_size_ = 0;
+    std::vector<ActionSpec> action_specs_;
+    uint32_t frame_sequence_ = 0;       // the server expects consecutive frame sequences across modes
+
+    bool isReset(unsigned long long step) const {
+        return options_.episode > 0 && step > 0 && step % options_.episode == 0;
+    }
+
+    // Resets go through ZMQ in every mode, timed apart from the steps
+    bool reset(BenchmarkClient& client, ModeResult& result, bool measured) {
+        auto start = Clock::now();
+        zmq::message_t reply;
+        if (!client.request("RESET:", reply) || !(isBinaryObservation(reply) || isJsonObservation(reply))) {
+            result.error = "no observation reply to RESET";
+            return false;
+        }
+        if (measured) {
+            result.reset_latency_us.push_back(elapsedUs(start));
+            ++result.resets;
+        }
+        return true;
+    }
+
+    bool setFormat(BenchmarkClient& client, const std::string& format, ModeResult& result) {
+        if (client.requestString("FORMAT:" + format) != "FORMAT OK") {
+            result.error = "FORMAT:" + format + " rejected";
+            return false;
+        }
+        return true;
+    }
+
+    std::string buildCommand(const std::vector<float>& action) const {
+        std::ostringstream cmd;
+        cmd << "CMD:";
+        if (options_.substeps > 0) {
+            cmd << "STEPS:" << options_.substeps << ";";
+        }
+        for (size_t i = 0; i < action_specs_.size() && i < action.size(); ++i) {
+            cmd << action_specs_[i].actuator_name << ":" << action_specs_[i].action_type << ":" << action[i] << ";";
+        }
+        cmd << "OBS:";
+        return cmd.str();
+    }
+
+    void buildFrame(const std::vector<float>& action, std::vector<char>& frame) {
+        ActionFrameHeader header;
+        header.magic = ACTION_FRAME_MAGIC;
+        header.version = OBSERVATION_VERSION;
+        header.substeps = static_cast<uint16_t>(options_.substeps);
+        header.count = static_cast<uint32_t>(action.size());
+        header.sequence = ++frame_sequence_;
+        frame.resize(sizeof(header) + action.size() * sizeof(float));
+        std::memcpy(frame.data(), &header, sizeof(header));
+        std::memcpy(frame.data() + sizeof(header), action.data(), action.size() * sizeof(float));
+    }
+
+    // Warmup steps are sent the same way but not measured
+    template <typename StepFn>
+    void measure(BenchmarkClient& client, ModeResult& result, StepFn step) {
+        std::vector<float> action(action_size_);
+        unsigned long long total = static_cast<unsigned long long>(options_.warmup) + options_.steps;
+        double reset_us = 0.0;
+        Clock::time_point start;
+
+        for (unsigned long long i = 0; i < total; ++i) {
+            bool measured = i >= options_.warmup;
+            if (i == options_.warmup) {
+                client.resetCounters();
+                start = Clock::now();
+            }
+            if (isReset(i)) {
+                auto reset_start = Clock::now();
+                if (!reset(client, result, measured)) return;
+                if (measured) reset_us += elapsedUs(reset_start);
+            }
+
+            syntheticAction(i, action);
+            auto step_start = Clock::now();
+            if (!step(action)) return;
+            if (measured) {
+                result.latency_us.push_back(elapsedUs(step_start));
+                ++result.steps;
+            }
+        }
+        result.elapsed_s = (elapsedUs(start) - reset_us) * 1e-6;
+        result.request_bytes = client.getRequestBytes();
+        result.reply_bytes = client.getReplyBytes();
+    }
+
+    void runStrings(bool binary, ModeResult& result) {
+        if (action_specs_.size() != action_size_) {
+            result.skipped = "CMD strings need the action config (--act)";
+            return;
+        }
+        zmq::context_t context;
+        BenchmarkClient client(context, endpoint_, false, options_.timeout_ms);
+        if (!setFormat(client, binary ? "BINARY" : "JSON", result) || !reset(client, result, false)) return;
+
+        measure(client, result, [&](const std::vector<float>& action) {
+            zmq::message_t reply;
+            if (!client.request(buildCommand(action), reply)
+                || !(binary ? isBinaryObservation(reply) : isJsonObservation(reply))) {
+                result.error = "invalid observation reply to CMD";
+                return false;
+            }
+            return true;
+        });
+        client.requestString("FORMAT:JSON");
+    }
+
+    void runFrames(ModeResult& result) {
+        zmq::context_t context;
+        BenchmarkClient client(context, endpoint_, false, options_.timeout_ms);
+        if (!setFormat(client, "BINARY", result) || !reset(client, result, false)) return;
+
+        std::vector<char> frame;
+        measure(client, result, [&](const std::vector<float>& action) {
+            buildFrame(action, frame);
+            zmq::message_t reply;
+            if (!client.send(frame.data(), frame.size()) || !client.receive(reply) || !isBinaryObservation(reply)) {
+                result.error = "invalid observation reply to action frame";
+                return false;
+            }
+            return true;
+        });
+        client.requestString("FORMAT:JSON");
+    }
+
+    // Steps through the segment, the bytes are the action and observation values copied through it
+    void runSharedMemory(ModeResult& result) {
+        zmq::context_t context;
+        BenchmarkClient client(context, endpoint_, false, options_.timeout_ms);
+        if (!setFormat(client, "BINARY", result) || !reset(client, result, false)) return;
+
+        std::istringstream reply(client.requestString("SHM:OPEN"));
+        std::string status, ok, name;
+        reply >> status >> ok >> name;
+        SharedMemoryClient shm;
+        if (status != "SHM" || ok != "OK" || !shm.attach(name)) {
+            result.error = "shared memory transport not available";
+            if (ok == "OK") client.requestString("SHM:CLOSE");
+            return;
+        }
+        client.setControlDoorbell(&shm);
+
+        measure(client, result, [&](const std::vector<float>& action) {
+            if (!shm.step(action.data(), action.size(), options_.substeps, options_.timeout_ms)) {
+                result.error = "no shared memory reply";
+                return false;
+            }
+            return true;
+        });
+        // Every step copies the same number of values through the segment
+        result.request_bytes += result.steps * action_size_ * sizeof(float);
+        result.reply_bytes += result.steps * shm.getObservationCount() * sizeof(float);
+
+        client.requestString("SHM:CLOSE");
+        client.setControlDoorbell(nullptr);
+        shm.detach();
+        client.requestString("FORMAT:JSON");
+    }
+
+    // Pipelined action frames on a DEALER socket, up to options_.depth requests in flight
+    void runAsync(ModeResult& result) {
+        if (!layout_.value("async", false)) {
+            result.skipped = "server not started with --async";
+            return;
+        }
+        zmq::context_t context;
+        BenchmarkClient client(context, endpoint_, true, options_.timeout_ms);
+        if (!setFormat(client, "BINARY", result) || !reset(client, result, false)) return;
+
+        std::vector<float> action(action_size_);
+        std::vector<char> frame;
+        std::vector<std::pair<uint32_t, Clock::time_point>> in_flight;
+        unsigned long long total = static_cast<unsigned long long>(options_.warmup) + options_.steps;
+        unsigned long long sent = 0, received = 0;
+        double reset_us = 0.0;
+        Clock::time_point start = Clock::now();
+        if (options_.warmup == 0) client.resetCounters();
+
+        while (received < total) {
+            // Drain the pipeline before a reset, resets are served in lockstep
+            bool reset_due = sent < total && isReset(sent);
+            while (sent < total && in_flight.size() < std::max(1u, options_.depth) && !(reset_due && !in_flight.empty())) {
+                if (reset_due) {
+                    auto reset_start = Clock::now();
+                    bool measured = sent >= options_.warmup;
+                    if (!reset(client, result, measured)) return;
+                    if (measured) reset_us += elapsedUs(reset_start);
+                    reset_due = false;
+                }
+                syntheticAction(sent, action);
+                buildFrame(action, frame);
+                if (!client.send(frame.data(), frame.size())) {
+                    result.error = "send failed";
+                    return;
+                }
+                in_flight.emplace_back(frame_sequence_, Clock::now());
+                ++sent;
+                reset_due = sent < total && isReset(sent);
+            }
+
+            zmq::message_t reply;
+            if (!client.receive(reply) || !isBinaryObservation(reply)) {
+                result.error = "invalid observation reply to action frame";
+                return;
+            }
+            ObservationHeader header;
+            std::memcpy(&header, reply.data(), sizeof(header));
+            if (in_flight.empty() || header.sequence != in_flight.front().first) {
+                result.error = "reply out of order";
+                return;
+            }
+            if (received >= options_.warmup) {
+                result.latency_us.push_back(elapsedUs(in_flight.front().second));
+                ++result.steps;
+            }
+            in_flight.erase(in_flight.begin());
+            ++received;
+            if (received == options_.warmup) {
+                client.resetCounters();
+                start = Clock::now();
+                reset_us = 0.0;
+            }
+        }
+        result.elapsed_s = (elapsedUs(start) - reset_us) * 1e-6;
+        result.request_bytes = client.getRequestBytes();
+        result.reply_bytes = client.getReplyBytes();
+        client.requestString("FORMAT:JSON");
+    }
+};
+
+nlohmann::json resultToJson(const ModeResult& result, unsigned int substeps) {
+    nlohmann::json out;
+    out["mode"] = result.mode;
+    out["ok"] = result.error.empty();
+    if (!result.error.empty()) {
+        out["error"] = result.error;
+    }
+    if (!result.skipped.empty()) {
+        out["skipped"] = result.skipped;
+    }
+    out["steps"] = result.steps;
+    out["resets"] = result.resets;
+    out["elapsed_s"] = result.elapsed_s;
+    double steps_per_s = result.elapsed_s > 0.0 ? result.steps / result.elapsed_s : 0.0;
+    out["steps_per_s"] = steps_per_s;
+    out["physics_steps_per_s"] = steps_per_s * substeps;
+    out["latency_us"] = latencySummary(result.latency_us);
+    out["reset_latency_us"] = latencySummary(result.reset_latency_us);
+    // Resets are part of the traffic, counted over the measured steps
+    out["request_bytes_per_step"] = result.steps > 0 ? static_cast<double>(result.request_bytes) / result.steps : 0.0;
+    out["reply_bytes_per_step"] = result.steps > 0 ? static_cast<double>(result.reply_bytes) / result.steps : 0.0;
+    return out;
+}
+
+void printResult(const nlohmann::json& result) {
+    std::cout << "[Benchmark] " << std::setw(7) << result["mode"].get<std::string>() << ": ";
+    if (!result["ok"].get<bool>()) {
+        std::cout << "FAILED (" << result["error"].get<std::string>() << ")" << std::endl;
+        return;
+    }
+    if (result.contains("skipped")) {
+        std::cout << "skipped (" << result["skipped"].get<std::string>() << ")" << std::endl;
+        return;
+    }
+    const nlohmann::json& latency = result["latency_us"];
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(9) << result["steps_per_s"].get<double>() << " steps/s  "
+              << "p50 " << std::setw(8) << latency["p50"].get<double>() << " us  "
+              << "p99 " << std::setw(8) << latency["p99"].get<double>() << " us  "
+              << std::setw(7) << result["request_bytes_per_step"].get<double>() << " B/"
+              << std::setw(7) << result["reply_bytes_per_step"].get<double>() << " B per step" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+std::string timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+int runBenchmark(const BenchmarkOptions& options, const std::string& endpoint, bool in_process) {
+    // The layout also tells whether the server runs the ROUTER (async) mode
+    nlohmann::json layout;
+    {
+        zmq::context_t context;
+        BenchmarkClient client(context, endpoint, false, options.timeout_ms);
+        std::string reply = client.requestString("HELLO");
+        if (reply.empty()) {
+            std::cerr << "[Benchmark] ERROR: No HELLO reply from " << endpoint << std::endl;
+            return 1;
+        }
+        layout = nlohmann::json::parse(reply, nullptr, false);
+        if (layout.is_discarded() || layout.value("status", "") != "READY") {
+            std::cerr << "[Benchmark] ERROR: Unexpected HELLO reply: " << reply << std::endl;
+            return 1;
+        }
+    }
+    unsigned int substeps = options.substeps > 0 ? options.substeps : layout.value("substeps", 1u);
+    std::cout << "[Benchmark] " << endpoint << ": " << layout.value("observation_size", 0u) << " observations, "
+              << layout.value("action_size", 0u) << " actions, " << substeps << " substeps" << std::endl;
+
+    Benchmark benchmark(options, endpoint, layout);
+    nlohmann::json results = nlohmann::json::array();
+    bool all_ok = true;
+    for (const std::string& mode : options.modes) {
+        nlohmann::json result = resultToJson(benchmark.run(mode), substeps);
+        printResult(result);
+        all_ok = all_ok && result["ok"].get<bool>();
+        results.push_back(result);
+    }
+
+    nlohmann::json report;
+    report["format"] = "stonefish_rl_benchmark";
+    report["version"] = 1;
+    report["timestamp"] = timestamp();
+    report["label"] = options.label;
+    report["endpoint"] = endpoint;
+    report["in_process"] = in_process;
+    report["scene"] = options.scene_path;
+    report["observation_config"] = options.obs_conf_path;
+    report["action_config"] = options.action_conf_path;
+    layout.erase("status");
+    report["server"] = layout;
+    report["config"] = {
+        {"steps", options.steps},
+        {"warmup", options.warmup},
+        {"episode", options.episode},
+        {"substeps", substeps},
+        {"depth", options.depth}
+    };
+    report["results"] = results;
+
+    std::ofstream out(options.output);
+    if (!out) {
+        std::cerr << "[Benchmark] ERROR: Cannot write " << options.output << std::endl;
+        return 1;
+    }
+    out << report.dump(2) << std::endl;
+    std::cout << "[Benchmark] Results written to " << options.output << std::endl;
+    return all_ok ? 0 : 2;
+}
+
+void sendExit(const std::string& endpoint, int timeout_ms) {
+    zmq::context_t context;
+    BenchmarkClient client(context, endpoint, false, timeout_ms);
+    client.requestString("EXIT");
+}
+
+// Headless simulator on a background thread, served by the learning loop of StonefishRLTest (ServeRequests)
+int runInProcess(const BenchmarkOptions& options) {
+    StonefishRL* sim = new StonefishRL(options.scene_path, options.obs_conf_path, options.action_conf_path,
+                                       options.frequency, options.endpoint, options.async_server);
+    if (sim->getEndpoint().empty()) {
+        std::cerr << "[Benchmark] ERROR: The simulator could not bind " << options.endpoint << std::endl;
+        return 1;
+    }
+    sf::ConsoleSimulationApp app("STONEFISH RL BENCHMARK", options.resources_path, sim);
+    sim->RestartScenario();
+    sim->StartSimulation();
+
+    std::thread server([&]() { sim->ServeRequests(app); });
+
+    // Wildcard hosts are not connectable
+    std::string endpoint = sim->getEndpoint();
+    size_t wildcard = endpoint.find("://*");
+    if (wildcard != std::string::npos) {
+        endpoint.replace(wildcard, 4, "://127.0.0.1");
+    }
+    int result = runBenchmark(options, endpoint, true);
+
+    sendExit(endpoint, options.timeout_ms);
+    server.join();
+    sim->StopSimulation();
+    return result;
+}
+
+void printUsage() {
+    std::cerr << "[ERROR] Usage: StonefishRLBenchmark (--connect ENDPOINT [--act ACTION_CONFIG_PATH] [--exit]"
+              << " | SCENE_PATH RESOURCES_PATH OBS_CONFIG_PATH ACTION_CONFIG_PATH [--async] [--endpoint ENDPOINT])"
+              << " [--modes json,binary,frames,shm,async] [--steps N] [--warmup N] [--episode N] [--substeps N]"
+              << " [--depth N] [--timeout MS] [--output FILE] [--label TEXT]" << std::endl;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    BenchmarkOptions options;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--connect" && has_value) {
+            options.connect = argv[++i];
+        } else if (arg == "--act" && has_value) {
+            options.action_conf_path = argv[++i];
+        } else if (arg == "--exit") {
+            options.exit_server = true;
+        } else if (arg == "--async") {
+            options.async_server = true;
+        } else if (arg == "--endpoint" && has_value) {
+            options.endpoint = argv[++i];
+        } else if (arg == "--modes" && has_value) {
+            options.modes = splitList(argv[++i]);
+        } else if (arg == "--steps" && has_value) {
+            options.steps = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--warmup" && has_value) {
+            options.warmup = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--episode" && has_value) {
+            options.episode = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--substeps" && has_value) {
+            options.substeps = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--depth" && has_value) {
+            options.depth = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--timeout" && has_value) {
+            options.timeout_ms = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output" && has_value) {
+            options.output = argv[++i];
+        } else if (arg == "--label" && has_value) {
+            options.label = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (!options.connect.empty()) {
+        int result = runBenchmark(options, options.connect, false);
+        if (options.exit_server) {
+            sendExit(options.connect, options.timeout_ms);
+        }
+        return result;
+    }
+
+    if (args.size() < 4) {
+        printUsage();
+        return 1;
+    }
+    options.scene_path = args[0];
+    options.resources_path = args[1];
+    options.obs_conf_path = args[2];
+    options.action_conf_path = args[3];
+
+    // Same exit path as the simulator, Stonefish objects are not torn down
+    std::exit(runInProcess(options));
+}
@@ -1,8 +1,21 @@
 #include "StonefishRL.h"
+#include "VectorEnvServer.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <cmath>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <cstring>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
 
 #include <Stonefish/core/GraphicalSimulationApp.h>
 #include <Stonefish/core/ConsoleSimulationApp.h>
@@ -39,33 +52,119 @@ int learning(void* data) {
 
     // Start the simulation (includes building the scenario)
     simApp.StartSimulation();
-    std::string nextStepSim;
-
-    while(nextStepSim != "EXIT")
-    {   
-        nextStepSim = myManager->RecieveInstructions(simApp);
-        
-        float time0 = simManager->getSimulationTime();
-
-        // TODO: l'StepSimulation va a 1000 Hz mentre que els agents van a 5-20Hz
-        // si cada vegada que enviem un StepSimulation fem un SendObservations
-        // es mooolt lent!
-        if(nextStepSim == "CMD")
+    auto startTime = std::chrono::steady_clock::now();
+    unsigned long long physicsSteps = myManager->ServeRequests(simApp);
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "[INFO] Learning thread finished. " << physicsSteps << " physics steps in " << elapsed << " s ("
+              << (elapsed > 0.0 ? physicsSteps / elapsed : 0.0) << " steps/s)" << std::endl;
+    myManager->ExitRequest();
+    return 0;
+}
+
+
+struct ReplayThreadData
+{
+    sf::SimulationApp& sim;
+    std::string log_path;
+    bool verify;
+};
+
+// Replays an episode log instead of serving a client, as fast as the physics runs
+int replay(void* data) {
+    ReplayThreadData* replayData = static_cast<ReplayThreadData*>(data);
+    sf::SimulationApp& simApp = replayData->sim;
+    StonefishRL* myManager = static_cast<StonefishRL*>(simApp.getSimulationManager());
+
+    while (simApp.getState() == sf::SimulationState::NOT_READY)
+    {
+        SDL_Delay(10);
+    }
+    simApp.StartSimulation();
+
+    int result = myManager->ReplayLog(simApp, replayData->log_path, replayData->verify);
+    std::exit(result);
+}
+
+
+// Print the bound endpoint and optionally write it to a file for the launcher (needed with automatic ports)
+bool announceEndpoint(const std::string& endpoint, const std::string& endpoint_file)
+{
+    if (endpoint.empty()) {
+        std::cerr << "[ERROR] The simulator could not bind its endpoint" << std::endl;
+        return false;
+    }
+    std::cout << "[INFO] ENDPOINT " << endpoint << std::endl;
+
+    if (!endpoint_file.empty()) {
+        // Written to a temporary file and renamed, so readers never see a partial address
+        std::string tmp_path = endpoint_file + ".tmp";
         {
-            simApp.StepSimulation();
-            myManager->SendObservations();
+            std::ofstream out(tmp_path);
+            out << endpoint << std::endl;
         }
-        else if (nextStepSim == "RESET"){
-            simApp.StepSimulation();
+        if (std::rename(tmp_path.c_str(), endpoint_file.c_str()) != 0) {
+            std::cerr << "[ERROR] Cannot write endpoint file: " << endpoint_file << std::endl;
+            return false;
         }
-       
-        //std::this_thread::sleep_for(std::chrono::milliseconds(1));   // Si el treiem (comentem aquesta linea) va el màxim de ràpid.
-                                                                     // Si el posem a 1, va approx. a real-time                                                                     
     }
+    return true;
+}
 
-    std::cout << "[INFO] Learning thread finished." << std::endl;
-    myManager->ExitRequest();
-    return 0;
+
+// Start a headless StonefishRLTest for one environment of the vectorized server
+pid_t spawnEnvironment(const std::vector<std::string>& args)
+{
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    // The environment ends with the server, even if the server is killed
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execv("/proc/self/exe", argv.data());
+    std::cerr << "[ERROR] Cannot start environment process: " << std::strerror(errno) << std::endl;
+    std::_Exit(1);
+}
+
+
+// N environments served in batches by VectorEnvServer. Stonefish keeps process-wide state, so each
+// environment is its own headless StonefishRLTest (normal learning loop) on a unix socket
+int runVectorEnvServer(int num_envs, const std::string& scene_path, const std::string& resources_path,
+                       const std::string& obser_conf_path, const std::string& action_conf_path,
+                       const std::string& endpoint, const std::string& endpoint_file)
+{
+    std::vector<pid_t> workers;
+    std::vector<std::string> worker_endpoints;
+    for (int i = 0; i < num_envs; ++i) {
+        std::string worker_endpoint = "ipc:///tmp/stonefish_rl_" + std::to_string(getpid()) + "_" + std::to_string(i);
+        worker_endpoints.push_back(worker_endpoint);
+        workers.push_back(spawnEnvironment({"StonefishRLTest", scene_path, resources_path, obser_conf_path, action_conf_path,
+                                            "--headless", "--endpoint", worker_endpoint}));
+    }
+
+    int result = 0;
+    {
+        VectorEnvServer server(worker_endpoints, endpoint);
+        if (!server.isReady() || !announceEndpoint(server.getEndpoint(), endpoint_file)) {
+            for (pid_t pid : workers) {
+                kill(pid, SIGTERM);
+            }
+            result = 1;
+        } else {
+            server.Run();
+        }
+    }
+
+    for (pid_t pid : workers) {
+        waitpid(pid, nullptr, 0);
+    }
+    std::cout << "[INFO] Simulation finished." << std::endl;
+    std::exit(result);
 }
 
 
@@ -73,31 +172,101 @@ int main(int argc, char **argv) {
 
     double frequency = 200; // Simulation frequency in Hz
     
-    if (argc < 4) {
-        std::cerr << "[ERROR] Arg input should be, SCENE_PATH, OBS_CONFIG_PATH, ACTION_CONFIG_PATH" << std::endl;
+    // Optional flags can go anywhere, the rest are positional arguments
+    bool headless = false;
+    int num_envs = 1;
+    std::string endpoint = "tcp://*:5555";
+    std::string endpoint_file;
+    bool async_mode = false;
+    std::string record_path;
+    std::string replay_path;
+    bool verify_replay = false;
+    std::string trajectory_dir;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--num-envs" && i + 1 < argc) {
+            num_envs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--endpoint" && i + 1 < argc) {
+            endpoint = argv[++i];
+        } else if (arg == "--endpoint-file" && i + 1 < argc) {
+            endpoint_file = argv[++i];
+        } else if (arg == "--async") {
+            async_mode = true;
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (arg == "--verify") {
+            verify_replay = true;
+        } else if (arg == "--trajectory" && i + 1 < argc) {
+            trajectory_dir = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 4) {
+        std::cerr << "[ERROR] Arg input should be, SCENE_PATH, RESOURCES_PATH, OBS_CONFIG_PATH, ACTION_CONFIG_PATH [--headless] [--num-envs N]"
+                  << " [--endpoint tcp://*:5555|tcp://127.0.0.1:*|ipc://PATH] [--endpoint-file PATH] [--async]"
+                  << " [--record LOG] [--replay LOG [--verify]] [--trajectory DIR]" << std::endl;
         return 1;
     }
 
-    std::string scene_path = argv[1]; 
-    std::string resources_path = argv[2]; 
-    std::string obser_conf_path = argv[3]; 
-    std::string action_conf_path = argv[4]; 
+    std::string scene_path = args[0]; 
+    std::string resources_path = args[1]; 
+    std::string obser_conf_path = args[2]; 
+    std::string action_conf_path = args[3]; 
+
+    if (num_envs > 1) {
+        if (async_mode) {
+            std::cout << "[INFO] --async is not supported with --num-envs, using REQ/REP" << std::endl;
+        }
+        return runVectorEnvServer(num_envs, scene_path, resources_path, obser_conf_path, action_conf_path,
+                                  endpoint, endpoint_file);
+    }
 
     sf::HelperSettings h;
     sf::RenderSettings r;
     r.windowW = 900;
     r.windowH = 600;
     
-    StonefishRL* simManager = new StonefishRL(scene_path, obser_conf_path, action_conf_path, frequency); // Create the StonefishRL simulation manager
+    // A replay needs no client (no socket) and no window
+    bool replaying = !replay_path.empty();
+    if (replaying) {
+        headless = true;
+        endpoint.clear();
+    }
+
+    StonefishRL* simManager = new StonefishRL(scene_path, obser_conf_path, action_conf_path, frequency, endpoint, async_mode); // Create the StonefishRL simulation manager
+    if (!replaying && !announceEndpoint(simManager->getEndpoint(), endpoint_file)) {
+        return 1;
+    }
+    if (!record_path.empty() && !simManager->StartRecording(record_path)) {
+        return 1;
+    }
+    if (!trajectory_dir.empty() && !simManager->StartTrajectory(trajectory_dir)) {
+        return 1;
+    }
 
-    sf::GraphicalSimulationApp app("DEMO STONEFISH RL", resources_path, r, h, simManager);
-    //sf::ConsoleSimulationApp app("DEMO STONEFISH RL", scene_path, simManager);
+    // Headless runs have no window or render loop, stepping is driven only by the learning thread
+    std::unique_ptr<sf::SimulationApp> app;
+    if (headless) {
+        std::cout << "[INFO] Running headless (no rendering)" << std::endl;
+        app = std::make_unique<sf::ConsoleSimulationApp>("DEMO STONEFISH RL", resources_path, simManager);
+    } else {
+        app = std::make_unique<sf::GraphicalSimulationApp>("DEMO STONEFISH RL", resources_path, r, h, simManager);
+    }
 
-    LearningThreadData data {app}; // is a struct that holds a reference to the sim app
-    SDL_Thread* learningThread = SDL_CreateThread(learning, "learningThread", &data);
+    LearningThreadData data {*app}; // is a struct that holds a reference to the sim app
+    ReplayThreadData replayData {*app, replay_path, verify_replay};
+    SDL_Thread* learningThread = replaying ? SDL_CreateThread(replay, "replayThread", &replayData)
+                                           : SDL_CreateThread(learning, "learningThread", &data);
 
-    app.Run(false, false, sf::Scalar(1/frequency));
+    app->Run(false, false, sf::Scalar(1/frequency));
 
     SDL_WaitThread(learningThread, nullptr);
     return 0;
-}
\ No newline at end of file
+}
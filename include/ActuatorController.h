@@ -5,7 +5,10 @@
 #include <Stonefish/actuators/Actuator.h>
 #include <Stonefish/actuators/Servo.h>
 #include <Stonefish/actuators/Thruster.h>
+#include "CommonTypes.h"
+#include "ControlPipeline.h"
 #include <unordered_map>
+#include <vector>
 #include <iostream>
 
 class ActuatorController {
@@ -17,8 +20,42 @@ public:
                       sf::SimulationManager* sim);
     
     void printActuatorInfo(sf::SimulationManager* sim);
+    
+    // Bind the action config specs to actuators, value i of an action vector drives spec i.
+    // Specs naming a controller of the pipeline (controller name, channel) write its setpoint
+    void bindActionSpecs(const ActionConfig& config, sf::SimulationManager* sim,
+                         ControlPipeline* controllers = nullptr);
+    
+    // Apply an action vector in spec order (no name lookups or parsing)
+    void applyActionVector(const float* values, size_t count);
+    
+    size_t getActionSize() const { return bound_actions_.size(); }
+    
+    // Last value applied to each action spec, by vector or by string command
+    const std::vector<float>& getLastActions() const { return last_actions_; }
 
 private:
+    enum class ActionMode {
+        INVALID,
+        SERVO_POSITION,
+        SERVO_VELOCITY,
+        THRUSTER_SETPOINT,
+        CONTROLLER_INPUT
+    };
+    
+    struct BoundAction {
+        ActionMode mode = ActionMode::INVALID;
+        sf::Servo* servo = nullptr;
+        sf::Thruster* thruster = nullptr;
+        float* input = nullptr;     // controller setpoint
+        std::string actuator_name;  // keys of the string commands
+        std::string action_type;
+    };
+    
+    std::vector<BoundAction> bound_actions_;
+    std::vector<float> last_actions_;
+    
+
     void controlServo(sf::Servo* servo, const std::unordered_map<std::string, float>& actions);
     void controlThruster(sf::Thruster* thruster, const std::unordered_map<std::string, float>& actions);
 };
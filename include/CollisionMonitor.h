@@ -0,0 +1,58 @@
+#ifndef COLLISIONMONITOR_H
+#define COLLISIONMONITOR_H
+
+#include <Stonefish/core/SimulationManager.h>
+#include <Stonefish/core/Robot.h>
+#include <Stonefish/entities/Entity.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-robot contacts from the Bullet contact manifolds, walked once per physics
+// step. Bodies are mapped to robots/targets through a pointer cache, so entity
+// names are only compared the first time a body is seen.
+class CollisionMonitor {
+public:
+    CollisionMonitor() = default;
+    
+    // Robots to watch and target name patterns. Without targets, any contact with
+    // a body that is not part of the robot counts as a collision
+    void configure(sf::SimulationManager* sim, const std::vector<sf::Robot*>& robots, 
+                   const std::vector<std::string>& targets);
+    
+    // Accumulate the contacts of the last physics step into the current interval
+    void update(sf::SimulationManager* sim);
+    
+    // Start a new observation interval (after each reply and on reset)
+    void beginInterval();
+    
+    bool isActive() const { return !robots_.empty(); }
+    
+    // Values over the current interval for robot i (index in configure order)
+    float getFlag(size_t i) const { return robots_[i].collided ? 1.0f : 0.0f; }
+    float getContactCount(size_t i) const { return robots_[i].max_contacts; }
+    float getImpulse(size_t i) const { return robots_[i].max_impulse; }
+
+private:
+    static constexpr int OTHER = -1;
+    static constexpr int TARGET = -2;
+    
+    struct RobotContacts {
+        std::string name;
+        std::string prefix;         // "<robot>/", robot links are named after their robot
+        bool collided = false;
+        float max_contacts = 0.0f;  // most contact points in one step of the interval
+        float max_impulse = 0.0f;   // largest summed contact impulse in one step [N s]
+        int step_contacts = 0;
+        float step_impulse = 0.0f;
+    };
+    
+    std::vector<RobotContacts> robots_;
+    std::vector<std::string> targets_;
+    std::unordered_map<const sf::Entity*, int> groups_;   // body -> robot index, TARGET or OTHER
+    
+    int classify(const sf::Entity* entity);
+    bool counts(int robot, int other) const;
+};
+
+#endif // COLLISIONMONITOR_H
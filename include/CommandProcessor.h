@@ -4,7 +4,6 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <unordered_set>
 #include "CommonTypes.h"
 
 
@@ -24,24 +23,23 @@ public:
         return commands_; 
     }
     
-    const std::unordered_set<std::string>& getRelevantObservations() const { 
-        return relevant_obs_names_; 
-    }
+    // Text after "OBS:" of the last command (empty: every observation), see StateManager::selectObservations
+    const std::string& getObservationFilter() const { return observation_filter_; }
+    
+    // Physics steps requested by the last command (0 when the command did not set STEPS)
+    unsigned int getSubsteps() const { return substeps_; }
     
     // Clear all stored commands and filters
     void clear();
-    
-    // Check if an object should be included in observations
-    bool isObjectRelevant(const std::string& objectName) const;
 
 private:
     std::unordered_map<std::string, std::unordered_map<std::string, float>> commands_;
-    std::unordered_set<std::string> relevant_obs_names_;
+    std::string observation_filter_;
+    unsigned int substeps_ = 0;
     
     // Helper methods
-    RobotResetInfo parseObjectFromJson(const std::string& object_str);
     void parseCommandToken(const std::string& token);
-    void parseObservationFilter(const std::string& obs_str);
+    void parseSubstepsToken(const std::string& token);
 };
 
 #endif // COMMANDPROCESSOR_H
\ No newline at end of file
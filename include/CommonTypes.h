@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <cstdint>
+#include <limits>
 
 // Simple observation specification
 struct ObservationSpec {
@@ -11,6 +13,11 @@ struct ObservationSpec {
     std::string field_type;     // "position", "rotation", "velocity", "collision"
     std::string component;      // "x", "y", "z", "yaw", "binary"
     std::string output_name;    // "girona_position_x", "collision_flag"
+    std::string aggregate;      // over the physics steps of a reply: "mean", "min", "max", "integral" ("" / "last": end value)
+    // Sensor channel range ("channels": {"start", "count", "stride"}), count values output_name[i]
+    int channel_start = -1;     // -1: channel of the field
+    unsigned int channel_count = 1;
+    unsigned int channel_stride = 1;
 };
 
 // Action specification
@@ -30,10 +37,104 @@ struct RobotResetInfo {
 // Configuration structures
 struct ObservationConfig {
     std::vector<ObservationSpec> specs;
+    std::vector<std::string> collision_targets;  // empty: any body that is not the robot itself
+    unsigned int history_length = 1;    // frames stacked in each reply, oldest first
+    bool history_actions = false;       // each frame ends with the actions applied before it
+};
+
+// Thruster of a "wrench" controller, geometry in the robot body frame
+struct ControllerThrusterSpec {
+    std::string name;                   // thruster actuator
+    std::vector<float> position;        // [x, y, z] [m]
+    std::vector<float> direction;       // thrust axis for a positive setpoint [x, y, z]
+    float max_thrust = 1.0f;            // thrust at max_setpoint [N]
+};
+
+// Low-level controller run at every physics step on the latest agent setpoint. Action specs
+// address it by name: {"actuator_name": <name>, "action_type": "SETPOINT"} ("FX".."TZ" for a wrench)
+struct ControllerSpec {
+    std::string name;
+    std::string type;                   // "servo_pid", "wrench", "rate_limit"
+    std::string actuator;               // servo_pid / rate_limit target
+    std::string mode = "position";      // servo setpoint: "position" or "velocity"
+    float kp = 1.0f;
+    float ki = 0.0f;
+    float kd = 0.0f;
+    float integral_limit = std::numeric_limits<float>::max();
+    float output_limit = std::numeric_limits<float>::max();  // servo_pid: |velocity command| [rad/s]
+    float rate_limit = 0.0f;            // max setpoint change per second (0 = none)
+    std::vector<ControllerThrusterSpec> thrusters;
+    std::string thrust_model = "quadratic";  // wrench: thrust ~ setpoint^2 ("quadratic") or ~ setpoint ("linear")
+    float max_setpoint = 1.0f;          // wrench: thruster setpoint limit
 };
 
 struct ActionConfig {
     std::vector<ActionSpec> specs;
+    unsigned int substeps = 1;  // physics steps per CMD when the command does not set STEPS
+    unsigned int max_substeps = 1000;  // most physics steps one request may ask for (STEPS / frame substeps)
+    std::vector<ControllerSpec> controllers;
+};
+
+// Reward/termination term, evaluated on the server after every step
+struct RewardTermSpec {
+    std::string type;                   // "distance", "proximity", "heading_error", "collision", "action_magnitude", "region"
+    std::string entity;                 // robot the term is about
+    std::string target;                 // robot used as target (optional)
+    std::vector<float> target_position; // fixed target [x, y, z], used when no target robot is given
+    float weight = 1.0f;
+    float radius = 1.0f;                // "proximity" range and spherical region radius [m]
+    bool has_target_yaw = false;        // "heading_error": absolute yaw instead of bearing to the target
+    float target_yaw = 0.0f;            // [rad]
+    std::string norm = "l2";            // "action_magnitude": "l2" (sum of squares) or "l1"
+    std::vector<float> box_min;         // box region (relative to the target), instead of a sphere
+    std::vector<float> box_max;
+    bool inside = true;                 // region fires when the entity is inside (false: outside)
+    bool terminate = false;             // region/collision: firing ends the episode
+};
+
+struct RewardConfig {
+    std::vector<RewardTermSpec> terms;
+    unsigned int max_episode_steps = 0; // replies after a reset before truncation (0 = never)
+
+    bool enabled() const { return !terms.empty() || max_episode_steps > 0; }
+};
+
+// Reward and end of episode of the last step
+struct StepOutcome {
+    float reward = 0.0f;
+    bool terminated = false;
+    bool truncated = false;
+};
+
+// One value of a reset pose: fixed, uniform in [a, b], normal (mean a, std b, clipped to
+// [min, max]) or one of the choices
+struct ResetDistribution {
+    enum class Type { FIXED, UNIFORM, NORMAL, CHOICE };
+    Type type = Type::FIXED;
+    float a = 0.0f;
+    float b = 0.0f;
+    float min = -std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::max();
+    std::vector<float> choices;
+};
+
+// Pose of a robot at reset, rotation in the same convention as the RESET payload
+struct ResetPoseSpec {
+    std::vector<ResetDistribution> position;  // [x, y, z]
+    std::vector<ResetDistribution> rotation;  // 3 values, empty keeps the current rotation
+};
+
+struct ResetEntitySpec {
+    std::string name;
+    std::vector<ResetPoseSpec> poses;   // one is picked uniformly at every reset
+};
+
+struct ResetConfig {
+    std::vector<ResetEntitySpec> entities;
+    bool has_seed = false;              // without seed the reset seeds come from std::random_device
+    uint64_t seed = 0;
+
+    bool enabled() const { return !entities.empty(); }
 };
 
 struct SimulationConfig {
@@ -41,4 +142,58 @@ struct SimulationConfig {
     ActionConfig action_config;
 };
 
+// Observation reply formats, selected by the client with "FORMAT:JSON" / "FORMAT:BINARY"
+enum class ObservationFormat {
+    JSON,
+    BINARY
+};
+
+// Header of a binary observation reply. It is followed by `count` little-endian float32 values
+struct ObservationHeader {
+    uint32_t magic;       // OBSERVATION_MAGIC
+    uint16_t version;     // OBSERVATION_VERSION
+    uint16_t flags;       // OBS_FLAG_* bits
+    uint32_t sequence;    // sequence of the action frame answered, otherwise previous reply + 1
+    uint32_t count;       // number of float32 values after the header
+    double sim_time;      // simulation time [s] when the observation was taken
+};
+static_assert(sizeof(ObservationHeader) == 24, "ObservationHeader must be 24 bytes on the wire");
+
+constexpr uint32_t OBSERVATION_MAGIC = 0x4C524653;  // "SFRL"
+constexpr uint16_t OBSERVATION_VERSION = 1;
+constexpr uint16_t OBS_FLAG_RESET = 1 << 0;         // reply to a RESET command
+constexpr uint16_t OBS_FLAG_BATCH = 1 << 1;         // num_envs x observation_size matrix (VectorEnvServer)
+constexpr uint16_t OBS_FLAG_OUTCOME = 1 << 2;       // followed by [reward, terminated, truncated] per env (reward config)
+constexpr uint16_t OBS_FLAG_RESET_INFO = 1 << 3;    // then a uint32 byte length and the JSON of the sampled reset
+
+// Batched step request for VectorEnvServer, followed by num_envs x action_size float32 values (row per env)
+struct BatchStepHeader {
+    uint32_t magic;       // BATCH_STEP_MAGIC
+    uint16_t version;     // OBSERVATION_VERSION
+    uint16_t substeps;    // physics steps per env (0 = action config default)
+    uint32_t num_envs;
+    uint32_t action_size;
+};
+static_assert(sizeof(BatchStepHeader) == 16, "BatchStepHeader must be 16 bytes on the wire");
+
+constexpr uint32_t BATCH_STEP_MAGIC = 0x42524653;   // "SFRB"
+
+// Binary CMD: header followed by `count` float32 values, one per action config spec (spec order)
+struct ActionFrameHeader {
+    uint32_t magic;       // ACTION_FRAME_MAGIC
+    uint16_t version;     // OBSERVATION_VERSION
+    uint16_t substeps;    // physics steps to hold the action (0 = action config default)
+    uint32_t count;       // number of float32 values after the header
+    uint32_t sequence;    // client sequence number
+};
+static_assert(sizeof(ActionFrameHeader) == 16, "ActionFrameHeader must be 16 bytes on the wire");
+
+constexpr uint32_t ACTION_FRAME_MAGIC = 0x41524653;  // "SFRA"
+
+// Highest sensor channel a "channels" range may reach (start + (count - 1) * stride)
+constexpr unsigned int MAX_SENSOR_CHANNELS = 65536;
+
+// World snapshot slots per environment (SNAPSHOT/RESTORE), slot 0 is captured after BuildScenario()
+constexpr unsigned int MAX_SNAPSHOT_SLOTS = 16;
+
 #endif // COMMON_TYPES_H
\ No newline at end of file
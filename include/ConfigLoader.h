@@ -15,8 +15,24 @@ public:
     
     static ObservationConfig getDefaultConfig();
 
+    // Action configuration (actuator specs and default substeps per command)
+    ActionConfig loadActionConfigFromFile(const std::string& filepath);
+
+    // Reward/termination terms ("reward_config", next to "observation_config")
+    RewardConfig loadRewardConfigFromFile(const std::string& filepath);
+    
+    // Reset pose distributions ("reset_config", next to "observation_config")
+    ResetConfig loadResetConfigFromFile(const std::string& filepath);
+
 private:
     ObservationConfig parseJsonConfig(const nlohmann::json& j);  // Fixed signature
+    ObservationSpec parseObservationSpec(const nlohmann::json& j);
+    ActionConfig parseActionJsonConfig(const nlohmann::json& j);
+    ControllerSpec parseControllerSpec(const nlohmann::json& j);
+    RewardConfig parseRewardJsonConfig(const nlohmann::json& j);
+    ResetConfig parseResetJsonConfig(const nlohmann::json& j);
+    ResetPoseSpec parseResetPose(const nlohmann::json& j);
+    ResetDistribution parseResetDistribution(const nlohmann::json& j);
     bool validateConfig(const ObservationConfig& config);
 };
 
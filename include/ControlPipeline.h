@@ -0,0 +1,82 @@
+#ifndef CONTROLPIPELINE_H
+#define CONTROLPIPELINE_H
+
+#include "CommonTypes.h"
+#include <Stonefish/core/SimulationManager.h>
+#include <Stonefish/actuators/Servo.h>
+#include <Stonefish/actuators/Thruster.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Low-level controllers of the action config ("controllers"), updated after every physics step
+// with the latest agent setpoints, so a policy acting at a few Hz still gets physics-rate control:
+//   servo_pid   PID on the servo position or velocity. The output is the velocity command of
+//               the servo (plus the setpoint as feedforward in velocity mode)
+//   wrench      body-frame wrench [FX, FY, FZ, TX, TY, TZ] allocated to thrusters with the
+//               least-squares inverse of the thruster geometry
+//   rate_limit  setpoint of one servo or thruster, slewed at most rate_limit per second
+// Every controller limits the rate of its setpoints when rate_limit > 0.
+class ControlPipeline {
+public:
+    ControlPipeline() = default;
+
+    void setConfig(const std::vector<ControllerSpec>& specs) { specs_ = specs; }
+    bool isEnabled() const { return !specs_.empty(); }
+
+    // Resolve actuators against the built scenario (before the action specs are bound)
+    void compile(sf::SimulationManager* sim);
+
+    // Setpoint written by an action spec (controller name and action type), nullptr if none
+    float* findInput(const std::string& name, const std::string& channel);
+
+    // One physics step of every controller
+    void update(float dt);
+
+    // Zero setpoints, integrators and rate limiters (new episode)
+    void reset();
+
+    std::vector<std::string> getControllerNames() const;
+
+    // Least-squares allocation T (n x 6, row major) of a thruster geometry B (6 x n, row major,
+    // column j is the wrench of thruster j at 1 N). False if B has not full rank
+    static bool solveAllocation(const std::vector<double>& b, size_t n, std::vector<double>& t);
+
+private:
+    enum class ControllerType {
+        INVALID,
+        SERVO_PID,
+        WRENCH,
+        RATE_LIMIT
+    };
+
+    struct Controller {
+        ControllerType type = ControllerType::INVALID;
+        const ControllerSpec* spec = nullptr;
+        sf::Servo* servo = nullptr;
+        sf::Thruster* thruster = nullptr;
+        bool velocity_mode = false;
+        std::vector<float> inputs;          // agent setpoints (1, or 6 for a wrench)
+        std::vector<float> setpoints;       // rate limited inputs
+        float integral = 0.0f;
+        float last_measurement = 0.0f;
+        bool has_measurement = false;
+        std::vector<sf::Thruster*> thrusters;
+        std::vector<float> allocation;      // thrusters x 6, row major
+    };
+
+    std::vector<ControllerSpec> specs_;
+    std::vector<Controller> controllers_;
+
+    static const std::unordered_map<std::string, ControllerType>& controllerTypes();
+    static const std::vector<std::string>& wrenchChannels();
+
+    bool compileWrench(sf::SimulationManager* sim, Controller& controller);
+    void updateServoPid(Controller& controller, float dt);
+    void updateWrench(Controller& controller);
+    void updateRateLimit(Controller& controller);
+    static void applyServo(sf::Servo* servo, bool velocity_mode, float value);
+    static float thrustToSetpoint(const ControllerSpec& spec, float thrust, float max_thrust);
+};
+
+#endif // CONTROLPIPELINE_H
@@ -0,0 +1,82 @@
+#ifndef EPISODELOG_H
+#define EPISODELOG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary episode log: one EpisodeLogHeader, then records of LogRecordHeader + payload.
+// Inputs (reset payloads, commands, action vectors) are replayed in order, the
+// observation records are used to verify the replay. All values little-endian.
+struct EpisodeLogHeader {
+    uint32_t magic;             // EPISODE_LOG_MAGIC
+    uint16_t version;           // EPISODE_LOG_VERSION
+    uint16_t reserved;
+    uint32_t observation_size;
+    uint32_t action_size;
+    double frequency;           // physics frequency of the recorded run [Hz]
+};
+static_assert(sizeof(EpisodeLogHeader) == 24, "EpisodeLogHeader must be 24 bytes");
+
+enum class LogRecordType : uint16_t {
+    RESET = 1,          // payload: RESET payload text
+    COMMAND = 2,        // payload: CMD text
+    ACTION = 3,         // payload: float32 action vector (binary frame or shared memory)
+    OBSERVATION = 4,    // payload: float32 observation vector sent in the reply
+    SNAPSHOT = 5,       // payload: uint32 slot
+    RESTORE = 6         // payload: uint32 slot
+};
+
+struct LogRecordHeader {
+    uint16_t type;          // LogRecordType
+    uint16_t substeps;      // physics steps the input was held for (0 for other records)
+    uint32_t sequence;      // input number, an observation has the number of the input it answers
+    uint32_t size;          // payload bytes after this header
+    uint32_t reserved;
+    double sim_time;        // simulation time when the record was written [s]
+};
+static_assert(sizeof(LogRecordHeader) == 24, "LogRecordHeader must be 24 bytes");
+
+constexpr uint32_t EPISODE_LOG_MAGIC = 0x45524653;    // "SFRE"
+constexpr uint16_t EPISODE_LOG_VERSION = 1;
+
+class EpisodeLogWriter {
+public:
+    EpisodeLogWriter() = default;
+    ~EpisodeLogWriter();
+    
+    bool open(const std::string& path, uint32_t observation_size, uint32_t action_size, double frequency);
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+    
+    // Inputs start a new sequence number, observations reuse the one of the last input
+    void writeInput(LogRecordType type, unsigned int substeps, double sim_time, const void* data, size_t size);
+    void writeObservation(double sim_time, const float* values, size_t count);
+
+private:
+    FILE* file_ = nullptr;
+    std::vector<char> buffer_;  // stdio buffer, records are appended without a syscall each
+    uint32_t sequence_ = 0;
+    
+    void write(LogRecordType type, unsigned int substeps, double sim_time, const void* data, size_t size);
+};
+
+class EpisodeLogReader {
+public:
+    EpisodeLogReader() = default;
+    ~EpisodeLogReader();
+    
+    bool open(const std::string& path);
+    const EpisodeLogHeader& getHeader() const { return header_; }
+    
+    // False at the end of the log (or on a truncated record)
+    bool next(LogRecordHeader& record, std::vector<char>& payload);
+
+private:
+    FILE* file_ = nullptr;
+    EpisodeLogHeader header_{};
+};
+
+#endif // EPISODELOG_H
@@ -0,0 +1,35 @@
+#ifndef HISTORYRING_H
+#define HISTORYRING_H
+
+#include <cstddef>
+#include <vector>
+
+// Frame stacking buffer of StateManager: the last `length` frames of `frame_size` floats,
+// handed out as one block, oldest first. The first frame of an episode stands in for the
+// frames before it.
+class HistoryRing {
+public:
+    HistoryRing() = default;
+
+    void resize(size_t length, size_t frame_size);
+    // The next frame starts a new episode
+    void clear() { filled_ = false; }
+
+    // Append a frame (observation values, then actions, the rest zero) and return the ordered
+    // block. A reset frame fills the whole history
+    const std::vector<float>& push(const float* observation, size_t num_observations,
+                                   const float* actions, size_t num_actions, bool reset);
+
+    size_t getLength() const { return length_; }
+    size_t getBlockSize() const { return block_.size(); }
+
+private:
+    size_t length_ = 1;
+    size_t frame_size_ = 0;
+    std::vector<float> ring_;       // length_ frames, next write at head_
+    std::vector<float> block_;      // ordered copy sent with the reply
+    size_t head_ = 0;
+    bool filled_ = false;           // false until the first frame of an episode
+};
+
+#endif // HISTORYRING_H
@@ -0,0 +1,63 @@
+#ifndef INPROCESSENV_H
+#define INPROCESSENV_H
+
+#include "StonefishRL.h"
+#include "CommonTypes.h"
+#include <Stonefish/core/ConsoleSimulationApp.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+
+// One headless StonefishRL environment stepped from the calling thread, without socket
+// or SimulationApp::Run loop (backend of the stonefish_rl_native Python module). Stonefish
+// allows a single SimulationApp per process, so only one instance may exist at a time.
+class InProcessEnv {
+public:
+    InProcessEnv(const std::string& scene_path, const std::string& resources_path,
+                 const std::string& observation_conf_path, const std::string& action_conf_path,
+                 double frequency = 200.0);
+    ~InProcessEnv();
+
+    InProcessEnv(const InProcessEnv&) = delete;
+    InProcessEnv& operator=(const InProcessEnv&) = delete;
+
+    // False if the scene could not be built, another instance is alive or after close()
+    bool isReady() const { return sim_ != nullptr; }
+    // Releases the simulator (also done by the destructor), a new instance may be created afterwards
+    void close();
+
+    size_t getObservationSize() const { return sim_->getObservationSize(); }
+    size_t getActionSize() const { return sim_->getActionSize(); }
+    unsigned int getMaxSubsteps() const { return sim_->getMaxSubsteps(); }
+    double getSimulationTime() { return sim_->getSimulationTime(); }
+    nlohmann::json describeLayout() const { return sim_->DescribeLayout(); }
+
+    // The observations are copied to `out` (at most `capacity` values), the count written is returned.
+    // Reset payload as after "RESET:" (JSON poses, or "" / "<seed>" with a reset config)
+    size_t reset(const std::string& payload, float* out, size_t capacity);
+    // Hold the actions for `substeps` physics steps (0 = action config default)
+    size_t step(const float* actions, size_t count, unsigned int substeps, float* out, size_t capacity);
+
+    bool saveSnapshot(unsigned int slot) { return sim_->SaveSnapshot(slot); }
+    // Returns the observation count of the restored state, 0 if the slot is empty
+    size_t restoreSnapshot(unsigned int slot, float* out, size_t capacity);
+
+    bool hasOutcome() const { return sim_->HasRewardConfig(); }
+    const StepOutcome& getLastOutcome() const { return sim_->GetLastOutcome(); }
+    // Poses sampled for the last reset (null without reset config)
+    const nlohmann::json& getLastResetInfo() const { return sim_->GetLastResetInfo(); }
+
+    // Same report as the STATS command
+    std::string stats(bool reset);
+
+private:
+    StonefishRL* sim_ = nullptr;                // owned by app_
+    std::unique_ptr<sf::ConsoleSimulationApp> app_;
+
+    static std::atomic<bool> instance_alive_;
+
+    size_t observe(uint16_t flags, float* out, size_t capacity);
+};
+
+#endif // INPROCESSENV_H
@@ -0,0 +1,31 @@
+#ifndef OBSERVATIONSELECTION_H
+#define OBSERVATIONSELECTION_H
+
+#include <cstddef>
+#include <vector>
+
+// Reply buffer of a CMD observation filter (StateManager::selectObservations). The selected specs
+// are ranges of the full observation vector; the reply holds exactly the values of the current
+// selection, the capacity is kept so a narrower filter after a wider one does not reallocate
+class ObservationSelection {
+public:
+    struct Range {
+        size_t offset;  // first value in the full vector
+        size_t count;
+    };
+    
+    // Appends a range, merged with the previous one when they are adjacent (one copy)
+    static void addRange(std::vector<Range>& ranges, size_t offset, size_t count);
+    
+    // Reply of `count` values written by the caller
+    float* begin(size_t count);
+    // Reply copied from the ranges of the full vector
+    const std::vector<float>& gather(const std::vector<Range>& ranges, const float* full);
+    
+    const std::vector<float>& get() const { return values_; }
+
+private:
+    std::vector<float> values_;
+};
+
+#endif // OBSERVATIONSELECTION_H
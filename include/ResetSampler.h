@@ -0,0 +1,44 @@
+#ifndef RESETSAMPLER_H
+#define RESETSAMPLER_H
+
+#include "CommonTypes.h"
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Samples the robot poses of a reset from the "reset_config" distributions. Every reset is
+// drawn from an RNG seeded with its own seed, so a reset is reproduced from the seed alone
+// (RESET:<seed>, episode logs). Resets without seed take the next seed of a per-environment
+// stream.
+class ResetSampler {
+public:
+    ResetSampler() = default;
+
+    void setConfig(const ResetConfig& config);
+    bool isEnabled() const { return config_.enabled(); }
+
+    // Poses of one reset, seeded with `seed`
+    std::vector<RobotResetInfo> sample(uint64_t seed);
+    uint64_t nextSeed() { return seed_stream_(); }
+
+    // Decimal seed of "RESET:<seed>", false unless it is all digits and fits in 64 bits
+    static bool parseSeed(const std::string& text, uint64_t& seed);
+    // Seed of environment `index` when one seed resets several environments (splitmix64), so
+    // environments do not replay each other's resets the way seed + index would for seeds s and s + 1
+    static uint64_t environmentSeed(uint64_t seed, uint64_t index);
+
+    // {"seed": s, "entities": [{"name", "position", "rotation"}]} of the last sample
+    const nlohmann::json& getLastSample() const { return last_sample_; }
+
+private:
+    ResetConfig config_;
+    std::mt19937_64 seed_stream_;
+    std::mt19937_64 rng_;
+    nlohmann::json last_sample_;
+
+    float draw(const ResetDistribution& dist);
+};
+
+#endif // RESETSAMPLER_H
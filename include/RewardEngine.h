@@ -0,0 +1,69 @@
+#ifndef REWARDENGINE_H
+#define REWARDENGINE_H
+
+#include "CommonTypes.h"
+#include "StateManager.h"
+#include <Stonefish/core/SimulationManager.h>
+#include <Stonefish/core/Robot.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reward, termination and truncation computed on the server from the "reward_config"
+// terms. Every term contributes weight * value, where value is:
+//   distance          distance between entity and target [m]
+//   proximity         max(0, 1 - distance / radius)
+//   heading_error     |yaw - target_yaw|, or |bearing to the target - yaw| [rad]
+//   collision         1 when the entity touched something since the last reply
+//   action_magnitude  sum of squares (l2) or absolute values (l1) of the last action
+//   region            1 when the entity is inside (or outside) a sphere/box around the target
+// Collision and region terms end the episode when "terminate" is set.
+class RewardEngine {
+public:
+    RewardEngine() = default;
+
+    void setConfig(const RewardConfig& config) { config_ = config; }
+    bool isEnabled() const { return config_.enabled(); }
+
+    // Resolve entities against the built scenario (call after the observation plan is compiled)
+    void compile(sf::SimulationManager* sim, StateManager& state);
+
+    // Outcome of the step that just finished. A reset starts a new episode and scores 0
+    const StepOutcome& evaluate(const std::vector<float>& actions, bool reset);
+    const StepOutcome& getLastOutcome() const { return outcome_; }
+
+private:
+    enum class TermType {
+        INVALID,
+        DISTANCE,
+        PROXIMITY,
+        HEADING_ERROR,
+        COLLISION,
+        ACTION_MAGNITUDE,
+        REGION
+    };
+
+    struct CompiledTerm {
+        TermType type = TermType::INVALID;
+        const RewardTermSpec* spec = nullptr;
+        sf::Robot* entity = nullptr;
+        sf::Robot* target = nullptr;    // nullptr: spec->target_position
+        float target_position[3] = {0.0f, 0.0f, 0.0f};
+        size_t collision_slot = 0;
+    };
+
+    RewardConfig config_;
+    std::vector<CompiledTerm> terms_;
+    const StateManager* state_ = nullptr;
+    StepOutcome outcome_;
+    unsigned int episode_steps_ = 0;
+
+    static const std::unordered_map<std::string, TermType>& termTypes();
+    float evaluateTerm(const CompiledTerm& term, const std::vector<float>& actions) const;
+    void targetPosition(const CompiledTerm& term, float out[3]) const;
+    static void robotPosition(sf::Robot* robot, float out[3]);
+    static float robotYaw(sf::Robot* robot);
+    static sf::Robot* findRobot(sf::SimulationManager* sim, const std::string& name);
+};
+
+#endif // REWARDENGINE_H
@@ -0,0 +1,131 @@
+#ifndef SHAREDMEMORYTRANSPORT_H
+#define SHAREDMEMORYTRANSPORT_H
+
+#include "CommonTypes.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Layout of the shared memory segment header. Observations (float32) start at
+// SHM_HEADER_SIZE and actions (float32) right after obs_capacity values.
+// Mirrored in scripts/core/shm_transport.py
+struct SharedMemoryHeader {
+    uint32_t magic;                     // SHM_MAGIC
+    uint32_t version;                   // SHM_VERSION
+    uint32_t obs_capacity;
+    uint32_t action_capacity;
+    std::atomic<uint32_t> request_seq;  // doorbell, incremented by the client
+    std::atomic<uint32_t> reply_seq;    // set to request_seq by the server when observations are ready
+    uint32_t substeps;                  // physics steps for the request (0 = config default)
+    uint32_t obs_count;
+    double sim_time;
+    uint32_t obs_sequence;
+    uint32_t flags;                     // SHM_FLAG_* bits
+    float reward;                       // server reward of the step (reward config)
+    uint32_t outcome;                   // SHM_OUTCOME_* bits
+    std::atomic<uint32_t> wake_seq;     // server futex word, incremented by the client after every step or control request
+    std::atomic<uint32_t> control_seq;  // incremented by the client before it sends a ZMQ control request
+};
+static_assert(sizeof(SharedMemoryHeader) == 64, "SharedMemoryHeader must be 64 bytes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory doorbell needs lock-free atomics");
+
+constexpr uint32_t SHM_MAGIC = 0x4D485346;     // "FSHM"
+constexpr uint32_t SHM_VERSION = 2;
+constexpr size_t SHM_HEADER_SIZE = sizeof(SharedMemoryHeader);
+constexpr uint32_t SHM_FLAG_CLOSED = 1 << 0;   // server closed the segment
+constexpr uint32_t SHM_OUTCOME_VALID = 1 << 0;       // reward/outcome were computed by the server
+constexpr uint32_t SHM_OUTCOME_TERMINATED = 1 << 1;
+constexpr uint32_t SHM_OUTCOME_TRUNCATED = 1 << 2;
+
+// What woke the server up in SharedMemoryTransport::waitRequest()
+enum class ShmWake {
+    NONE,       // timeout
+    STEP,       // a step request is pending in the segment
+    CONTROL     // the client is sending a control request through ZMQ
+};
+
+// Same-host transport: observation and action vectors live in a POSIX shared memory
+// segment and each step is signalled with a futex doorbell instead of a ZMQ round trip.
+// The server sleeps on a single futex word (wake_seq) that the client rings for steps and,
+// before any ZMQ control request, for the control channel
+class SharedMemoryTransport {
+public:
+    SharedMemoryTransport() = default;
+    ~SharedMemoryTransport();
+
+    SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+    SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+    // Create (or recreate) the segment "/<name>"
+    bool open(const std::string& name, size_t obs_capacity, size_t action_capacity);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+    const std::string& getName() const { return name_; }
+    
+    // Wait up to timeout_ms for the client doorbell
+    ShmWake waitRequest(int timeout_ms);
+    
+    // Pending request data
+    const float* getActions() const { return actions_; }
+    size_t getActionCount() const { return action_capacity_; }
+    unsigned int getSubsteps() const { return header_->substeps; }
+    
+    // Write the observations (and the server outcome, if any) and ring the reply doorbell
+    void publishObservations(const float* values, size_t count, double sim_time, uint32_t sequence,
+                             const StepOutcome* outcome = nullptr);
+
+private:
+    std::string name_;
+    int fd_ = -1;
+    size_t size_ = 0;
+    SharedMemoryHeader* header_ = nullptr;
+    float* observations_ = nullptr;
+    float* actions_ = nullptr;
+    size_t obs_capacity_ = 0;
+    size_t action_capacity_ = 0;
+    uint32_t served_seq_ = 0;
+    uint32_t served_control_ = 0;
+
+    ShmWake pendingWake();
+
+    friend class SharedMemoryClient;
+    static void futexWait(std::atomic<uint32_t>* addr, uint32_t expected, int timeout_ms);
+    static void futexWake(std::atomic<uint32_t>* addr);
+};
+
+// Client side of the segment for C++ tools (e.g. the benchmark), same protocol as
+// scripts/core/shm_transport.py
+class SharedMemoryClient {
+public:
+    SharedMemoryClient() = default;
+    ~SharedMemoryClient();
+
+    SharedMemoryClient(const SharedMemoryClient&) = delete;
+    SharedMemoryClient& operator=(const SharedMemoryClient&) = delete;
+
+    // Map the segment "/<name>" created by the server ("SHM:OPEN" reply)
+    bool attach(const std::string& name);
+    void detach();
+    bool isAttached() const { return header_ != nullptr; }
+
+    // Write the actions, ring the doorbell and wait for the reply. False on timeout or closed segment
+    bool step(const float* actions, size_t count, unsigned int substeps, int timeout_ms);
+    // Call before sending a ZMQ control request, the server only listens to ZMQ when rung
+    void notifyControl();
+
+    const float* getObservations() const { return observations_; }
+    size_t getObservationCount() const { return header_ ? header_->obs_count : 0; }
+    size_t getActionCapacity() const { return header_ ? header_->action_capacity : 0; }
+
+private:
+    int fd_ = -1;
+    size_t size_ = 0;
+    SharedMemoryHeader* header_ = nullptr;
+    float* observations_ = nullptr;
+    float* actions_ = nullptr;
+
+    void ring();
+};
+
+#endif // SHAREDMEMORYTRANSPORT_H
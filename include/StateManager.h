@@ -2,6 +2,10 @@
 #define STATEMANAGER_H
 
 #include "CommonTypes.h"
+#include "CollisionMonitor.h"
+#include "HistoryRing.h"
+#include "ObservationSelection.h"
+#include "SubstepAccumulators.h"
 #include <Stonefish/core/SimulationManager.h>
 #include <Stonefish/core/Robot.h>
 #include <Stonefish/sensors/Sample.h>
@@ -15,7 +19,7 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
-#include <functional>
+#include <unordered_map>
 class StateManager {
 public:
     StateManager();
@@ -23,15 +27,54 @@ public:
     // Configuration
     void setObservationConfig(const ObservationConfig& config);
     
-    // Observation methods
-    std::vector<float> getObservationVector(sf::SimulationManager* sim);
-    std::vector<std::string> getObservationNames() const;
+    // Resolve the observation specs against the built scenario (call after BuildScenario)
+    void compileObservationPlan(sf::SimulationManager* sim);
+    
+    // Observation methods. With a filter selected only its entries are returned (in spec order);
+    // extract_all still reads every spec so the full vector stays available
+    const std::vector<float>& getObservationVector(sf::SimulationManager* sim, bool extract_all = false);
+    const std::vector<float>& getUnfilteredObservationVector() const { return observation_buffer_; }
+    
+    // Select the observations of the next replies ("OBS:" text of a CMD, output or entity names
+    // separated by ';'). Compiled filters are cached by string. Empty selects everything
+    bool selectObservations(const std::string& filter);
+    void clearObservationFilter() { active_filter_ = nullptr; }
+    bool isFiltered() const { return active_filter_ != nullptr; }
+    
+    // Accumulate the contacts of the physics step that just finished
+    void updateCollisions(sf::SimulationManager* sim);
+    // Contacts are reported per reply, start the next interval once the reply is built
+    void resetCollisions() { collision_monitor_.beginInterval(); }
+    
+    // Specs with an "aggregate" accumulate their value after every physics step of the reply
+    bool hasAggregates() const { return !aggregated_entries_.empty(); }
+    void updateAggregates(sf::SimulationManager* sim, float dt);
+    void resetAggregates();
+    
+    // Sensors are only re-read when they produced a new sample. Call when sensor state changed
+    // outside the physics step (snapshot restore) to read every sensor again
+    void invalidateSensorCache();
+    
+    // Contact flag of a robot over the current interval, for users outside the observation plan
+    size_t watchCollisions(sf::SimulationManager* sim, sf::Robot* robot);
+    float getCollisionFlag(size_t slot) const { return collision_monitor_.getFlag(slot); }
+    // Names of the reply values (stacked frames with a history), or of the observation specs only
+    std::vector<std::string> getObservationNames(bool stacked = true) const;
+    
+    // Frame stacking ("history" of the observation config): a reply holds the last K frames,
+    // oldest first, each frame the full observation vector followed by the applied actions
+    bool hasHistory() const { return history_length_ > 1 || history_actions_; }
+    void setActionNames(const std::vector<std::string>& names);
+    // Append the current frame (observation vector of the last full extraction) and return the
+    // ordered block. A reset frame fills the whole history
+    const std::vector<float>& pushHistory(const std::vector<float>& actions, bool reset);
+    void clearHistory() { history_.clear(); }
     
     // Robot management
     void updateRobotPosition(const std::vector<RobotResetInfo>& robot_info, sf::SimulationManager* sim);
     
     // Utility
-    size_t getObservationSize() const { return observation_specs_.size(); }
+    size_t getObservationSize() const { return hasHistory() ? history_.getBlockSize() : observation_width_; }
     void printObservationSpecs() const;
 
     
@@ -39,47 +82,166 @@ public:
 private:
     ObservationConfig observation_config_;
     std::vector<ObservationSpec> observation_specs_;
+    size_t observation_width_ = 0;  // values of all specs, a channel range counts several
+    
+    // Where the value of a spec comes from once resolved
+    enum class ObservationSource {
+        INVALID,    // entity or field unknown, always 0
+        ROBOT,
+        SENSOR,
+        ACTUATOR,
+        COLLISION,
+        SENSOR_AGE  // simulation time since the sensor's last sample [s]
+    };
+    
+    enum class Aggregate {
+        LAST,
+        MEAN,
+        MIN,
+        MAX,
+        INTEGRAL    // sum of value * dt [value * s]
+    };
+    
+    enum class RobotField {
+        POSITION_X,
+        POSITION_Y,
+        POSITION_Z,
+        ROLL,
+        PITCH,
+        YAW
+    };
+    
+    // Telemetry read straight from the actuator objects (no encoder sensors needed)
+    enum class ActuatorField {
+        SERVO_POSITION,     // [rad] or [m]
+        SERVO_VELOCITY,
+        SERVO_EFFORT,       // [Nm] or [N]
+        THRUSTER_OMEGA,     // propeller speed [rad/s]
+        THRUSTER_THRUST,    // [N]
+        THRUSTER_TORQUE,    // [Nm]
+        THRUSTER_SETPOINT
+    };
+    
+    enum class CollisionField {
+        FLAG,       // "binary": any contact during the interval
+        CONTACTS,   // most contact points in one step
+        IMPULSE     // largest summed contact impulse in one step
+    };
+    
+    // Sensor field -> scalar sensor type and channel index in its sample
+    struct SensorField {
+        sf::ScalarSensorType type;
+        unsigned int channel;
+        bool any_type;      // generic "sensor.*" fields accept every scalar sensor
+        bool age = false;   // age of the last sample instead of a channel
+    };
     
-    // Initialization
-    void initializeExtractors();
+    // One entry per observation spec, in output order
+    struct CompiledObservation {
+        ObservationSource source = ObservationSource::INVALID;
+        size_t slot = 0;            // index into robot_slots_ / sensor_slots_ / actuator_slots_ / collision_robots_
+        unsigned int channel = 0;   // RobotField, ActuatorField, CollisionField or sensor channel
+        Aggregate aggregate = Aggregate::LAST;
+        size_t accumulator = 0;     // index into the aggregate arrays
+        unsigned int count = 1;     // values written (sensor channel range)
+        unsigned int stride = 1;
+    };
     
-    // Field extraction system Used during initialization to map field types from the Json to extractor functions
+    // Robots and sensors used by the plan, each read only once per observation
+    struct RobotSlot {
+        sf::Robot* robot;
+        std::string name;
+        bool needs_euler = false;
+        float position[3];
+        float euler[3];     // roll, pitch, yaw
+    };
+    
+    // Values of the last sample read, kept until the sensor has a new one (slow DVL/GPS/pressure)
+    struct SensorSlot {
+        sf::ScalarSensor* sensor;
+        unsigned int num_channels = 0;  // channels copied from the last sample
+        std::vector<float> values;
+        bool cached = false;            // values hold the sensor's latest sample
+        double timestamp = 0.0;         // simulation time of that sample [s]
+        float age = 0.0f;               // updated at every observation
+    };
+    
+    std::vector<CompiledObservation> plan_;
+    std::vector<RobotSlot> robot_slots_;
+    std::vector<SensorSlot> sensor_slots_;
+    // Actuators resolved to their concrete type once, read without casts
+    struct ActuatorSlot {
+        sf::Servo* servo = nullptr;
+        sf::Thruster* thruster = nullptr;
+    };
+    std::vector<ActuatorSlot> actuator_slots_;
+    std::vector<float> observation_buffer_;
+    std::vector<sf::Robot*> collision_robots_;
+    CollisionMonitor collision_monitor_;
+    
+    // Subset of the plan requested by a CMD filter
+    struct ObservationFilter {
+        std::vector<uint64_t> bits;     // bit i % 64 of word i / 64 selects plan entry i
+        std::vector<char> robot_slots;  // slots the selection reads
+        std::vector<char> sensor_slots;
+        std::vector<ObservationSelection::Range> ranges;  // selected values of the full vector
+        size_t count = 0;
+    };
+    static const size_t MAX_CACHED_FILTERS = 64;
+    std::unordered_map<std::string, ObservationFilter> filter_cache_;
+    const ObservationFilter* active_filter_ = nullptr;
+    const ObservationFilter* last_filter_ = nullptr;
+    std::string last_filter_key_;
+    ObservationSelection selection_;
+    
+    // Substep accumulators, one element per aggregated plan entry (structure of arrays)
+    std::vector<size_t> aggregated_entries_;    // plan index of each accumulator
+    std::vector<char> aggregate_robot_slots_;   // slots read at every physics step
+    std::vector<char> aggregate_sensor_slots_;
+    std::vector<float> aggregate_values_;       // values of the current physics step
+    SubstepAccumulators accumulators_;
+    
+    // History: history_length_ frames of the observation vector (plus the actions)
+    size_t history_length_ = 1;
+    bool history_actions_ = false;
+    std::vector<std::string> action_names_;
+    HistoryRing history_;
+    void resizeHistory();
+    
+    // Field tables, only used while compiling the plan
     /* 
-    This maps the extractor functions for robot fields. creating a reference to retrive the value based on field type.
-    Example: "position.x" -> function to extract x position from robot
+    Map the "field_type.component" strings of the JSON config to what has to be read.
+    Example: "position.x" -> RobotField::POSITION_X, "odom.position.x" -> {ODOM, channel 0}
     */
-    std::unordered_map<std::string, std::function<float(sf::SimulationManager*, const std::string&)>> robot_extractors_;
-    // Sensors
-    std::unordered_map<std::string, std::function<float(sf::SimulationManager*, const std::string&)>> sensor_extractors_;
-    // Actuators
-    std::unordered_map<std::string, std::function<float(sf::SimulationManager*, const std::string&)>> actuator_extractors_;
+    static const std::unordered_map<std::string, RobotField>& robotFields();
+    static const std::unordered_map<std::string, SensorField>& sensorFields();
+    static const std::unordered_map<std::string, ActuatorField>& actuatorFields();
+    static const std::unordered_map<std::string, CollisionField>& collisionFields();
+    static const std::unordered_map<std::string, Aggregate>& aggregates();
+    
+    size_t robotSlot(sf::Robot* robot);
+    size_t sensorSlot(sf::ScalarSensor* sensor);
+    size_t actuatorSlot(sf::Servo* servo, sf::Thruster* thruster);
+    size_t collisionSlot(sf::Robot* robot);
     
-    // Extraction methods
-    float extractRobotField(sf::SimulationManager* sim, const ObservationSpec& spec);
-    float extractSensorField(sf::SimulationManager* sim, const ObservationSpec& spec);
-    float extractActuatorField(sf::SimulationManager* sim, const ObservationSpec& spec);
+    // Per observation refresh of the slots (only the used ones when given)
+    void refreshRobotSlots(const std::vector<char>* used = nullptr);
+    void refreshSensorSlots(double sim_time, const std::vector<char>* used = nullptr);
+    float readEntry(const CompiledObservation& entry) const;
+    float readValue(const CompiledObservation& entry) const;   // current value, ignoring the aggregate
+    float* writeEntry(const CompiledObservation& entry, float* out) const;  // returns the end of its values
+    void compileAggregates();
+    
+    ObservationFilter compileFilter(const std::string& filter) const;
+    void clearFilterCache();
     
     // Entity finding
     sf::Robot* findRobot(sf::SimulationManager* sim, const std::string& name);
     sf::Sensor* findSensor(sf::SimulationManager* sim, const std::string& name);
     sf::Actuator* findActuator(sf::SimulationManager* sim, const std::string& name);
-    
-    // Collision detection
-    float getCollisionFlag(sf::SimulationManager* sim, const std::string& robot_name);
 
     // Robot positioning helper
     void positionSingleRobot(const RobotResetInfo& info, sf::SimulationManager* sim);
-    // used to extract information from sensors
-    /* 
-    \param sim is the stonefish class
-    \param name is the sensors name ex(ROBOT/Sensor, girona500/gps.......)
-    \param expected_type 
-    \param channel_index the position of this value in the msg(ex, 0,1,2,3,4,5 .... )
-    */
-    static float extractFromSensorType(sf::SimulationManager* sim, const std::string& name, 
-                           sf::ScalarSensorType expected_type, int channel_index);
-
-    
 };
 
-#endif // STATEMANAGER_H
\ No newline at end of file
+#endif // STATEMANAGER_H
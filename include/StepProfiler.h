@@ -0,0 +1,79 @@
+#ifndef STEPPROFILER_H
+#define STEPPROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Phases of one learning loop iteration
+enum class StepPhase {
+    RECEIVE,    // waiting for / receiving the request
+    PARSE,      // command decoding
+    APPLY,      // ActuatorController
+    STEP,       // physics substeps
+    OBSERVE,    // StateManager::getObservationVector
+    SEND,       // serialization and send
+    COUNT
+};
+
+// Log-linear (HDR style) latency histogram in nanoseconds: 16 sub-buckets per
+// power of two, so every bucket is within ~6% of the recorded value
+class LatencyHistogram {
+public:
+    void record(uint64_t ns);
+    void reset();
+    
+    uint64_t getCount() const { return count_; }
+    uint64_t getMax() const { return max_; }
+    // Upper bound of the bucket holding the p-th percentile (p in [0, 100])
+    uint64_t percentile(double p) const;
+
+private:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 40;     // ~1100 s, longer values go to the last bucket
+    static constexpr int NUM_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    std::array<uint64_t, NUM_BUCKETS> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+
+    static int bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(int index);
+};
+
+// Per-phase timers for the learning loop, cheap enough to stay enabled
+class StepProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StepProfiler();
+
+    static Clock::time_point now() { return Clock::now(); }
+    
+    // Record the time elapsed since `start` for a phase
+    void record(StepPhase phase, Clock::time_point start) {
+        histograms_[static_cast<size_t>(phase)].record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+    }
+    
+    // One agent step (reply) covering `substeps` physics steps
+    void countStep(unsigned int substeps) {
+        ++steps_;
+        physics_steps_ += substeps;
+    }
+    
+    void reset();
+    
+    // JSON report: p50/p90/p99/max per phase [us] plus steps/s since the last reset
+    std::string report() const;
+
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(StepPhase::COUNT)> histograms_;
+    uint64_t steps_ = 0;
+    uint64_t physics_steps_ = 0;
+    Clock::time_point since_;
+};
+
+#endif // STEPPROFILER_H
@@ -15,34 +15,121 @@
 #include "StateManager.h"
 #include "ConfigLoader.h" 
 #include "ActuatorController.h"
+#include "ControlPipeline.h"
+#include "SharedMemoryTransport.h"
+#include "StepProfiler.h"
+#include "WorldSnapshot.h"
+#include "EpisodeLog.h"
+#include "TrajectoryRecorder.h"
+#include "RewardEngine.h"
+#include "ResetSampler.h"
 #include "CommonTypes.h"
 #include <vector>
 #include <string>
+#include <functional>
 
 class StonefishRL : public sf::SimulationManager {
 public:
-    StonefishRL(const std::string &path, const std::string &observation_conf_path, const std::string &action_conf_path, double frequency);
+    // An empty address creates no socket (instances driven in-process, e.g. by InProcessEnv).
+    // async_mode serves pipelined requests on a ROUTER socket instead of REQ/REP lockstep
+    StonefishRL(const std::string &path, const std::string &observation_conf_path, const std::string &action_conf_path, 
+                double frequency, const std::string &address = "tcp://*:5555", bool async_mode = false);
     
     std::string RecieveInstructions(sf::SimulationApp& simApp);
-    void SendObservations();
+    // Learning loop of StonefishRLTest (also driven by the benchmark): serve requests until EXIT.
+    // Returns the number of physics steps taken
+    unsigned long long ServeRequests(sf::SimulationApp& simApp);
+    void SendObservations(uint16_t flags = 0);
     void ApplyCommands(const std::string& str_cmds);
     void BuildScenario();
+    void SimulationStepCompleted(sf::Scalar timeStep) override;
     void ExitRequest();
+    
+    // Number of physics steps the last CMD should be held for
+    unsigned int getSubsteps() const;
+    unsigned int getDefaultSubsteps() const { return action_config_.substeps; }
+    unsigned int getMaxSubsteps() const { return action_config_.max_substeps; }
+    // False (and logged) when a request asks for more than max_substeps physics steps
+    bool CheckSubsteps(unsigned int requested) const;
+    StepProfiler& getProfiler() { return profiler_; }
+
+    // In-process stepping API (no sockets and no SimulationApp loop)
+    void ApplyActionVector(const float* values, size_t count);
+    // Fixed steps through the process SimulationApp, same as the learning loop
+    void StepPhysics(unsigned int steps);
+    // Observation after the last step; also evaluates the reward config (flags: OBS_FLAG_RESET)
+    const std::vector<float>& GetObservations(uint16_t flags = 0);
+    bool HasRewardConfig() const { return reward_engine_.isEnabled(); }
+    const StepOutcome& GetLastOutcome() const { return reward_engine_.getLastOutcome(); }
+    // Explicit poses (JSON), or with a reset config "" / "<seed>" to sample them.
+    // Returns the payload that reproduces the reset (the seed when sampled)
+    std::string ResetRobots(const std::string& reset_payload);
+    // Reset sequence of every backend (learning loop, replay, vectorized workers, InProcessEnv):
+    // respawn, observe the respawned state, then one physics step. Returns what ResetRobots returns
+    std::string Reset(const std::string& reset_payload, const std::function<void()>& observe);
+    const nlohmann::json& GetLastResetInfo() const { return reset_sampler_.getLastSample(); }
+    
+    // Episode log of every received input (and the observations replied), see EpisodeLog.h
+    bool StartRecording(const std::string& path);
+    void StopRecording() { recorder_.close(); }
+    
+    // Offline dataset of (observation, action, reward, flags, sim time) rows, written in the background
+    bool StartTrajectory(const std::string& directory);
+    void StopTrajectory() { trajectory_.close(); }
+    
+    // Run a recorded log without client, stepping like the learning loop. With verify, every
+    // observation must match the recorded one bit for bit. Returns the process exit code
+    int ReplayLog(sf::SimulationApp& simApp, const std::string& path, bool verify);
+    
+    // World snapshots, slot 0 is captured right after BuildScenario()
+    bool SaveSnapshot(unsigned int slot);
+    bool RestoreSnapshot(unsigned int slot);
+    size_t getObservationSize() const { return state_manager_.getObservationSize(); }
+    size_t getActionSize() const { return actuator_controller_.getActionSize(); }
+    
+    // Bound endpoint (empty without a socket or if binding failed)
+    std::string getEndpoint() const { return communicator ? communicator->getEndpoint() : ""; }
+    
+    // Observation/action layout reported in the READY reply to HELLO
+    nlohmann::json DescribeLayout() const;
 
 private:
     std::string scenePath;
+    double frequency_;
     ZMQCommunicator* communicator;
     CommandProcessor command_processor_;
     StateManager state_manager_;
     ActuatorController actuator_controller_;
+    ControlPipeline control_pipeline_;
+    RewardEngine reward_engine_;
+    ResetSampler reset_sampler_;
+    nlohmann::json reset_info_;         // sampled poses for the next reset reply (null: none)
+    std::string reply_trailer_;         // outcome/reset info appended to binary replies
+    ActionConfig action_config_;
+    ObservationFormat observation_format_ = ObservationFormat::JSON;
+    SharedMemoryTransport shm_transport_;
+    bool shm_step_pending_ = false;     // the current CMD came through shared memory
+    unsigned int pending_substeps_ = 0; // substeps requested by the current CMD (0 = config default)
+    std::vector<float> action_buffer_;  // last binary action frame
+    StepProfiler profiler_;
+    uint32_t reply_sequence_ = 0;
+    uint32_t action_sequence_ = 0;      // sequence of the pending action frame, echoed by its reply (0 = none)
+    uint32_t last_action_sequence_ = 0; // frames must arrive in order
+    bool async_mode_ = false;
+    std::vector<WorldSnapshot> snapshots_;
+    EpisodeLogWriter recorder_;
+    TrajectoryRecorder trajectory_;
+    static const int SHM_CONTROL_FALLBACK_MS = 500;  // ZMQ check while the shared memory doorbell is silent
     
     std::vector<std::string> robotNames;
     std::vector<std::string> sensorNames;
     std::vector<std::string> actuatorNames;
 
     // StonefishRL specific methods that remain
-    std::vector<std::string> RobotCollisionDetector(std::string& collision_robot);
-    bool CheckNameForCollision(std::string name, std::string name2, std::string& collision_robot);
+    bool HandleSharedMemoryCommand(const std::string& cmd);
+    void HandleTrajectoryCommand(const std::string& cmd);
+    bool HandleActionFrame(const zmq::message_t& request);
+    bool ParseSnapshotSlot(const std::string& arg, unsigned int& slot) const;
     void PrintAll();
 };
 
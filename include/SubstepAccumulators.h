@@ -0,0 +1,36 @@
+#ifndef SUBSTEPACCUMULATORS_H
+#define SUBSTEPACCUMULATORS_H
+
+#include <cstddef>
+#include <vector>
+
+// Accumulators of the aggregated observations of StateManager over one reply interval, one
+// element per aggregated spec in contiguous arrays, all updated in one pass per physics step
+class SubstepAccumulators {
+public:
+    SubstepAccumulators() = default;
+
+    void resize(size_t count);
+    size_t size() const { return sum_.size(); }
+
+    // One physics step of length dt, `values` holds one value per accumulator
+    void add(const float* values, float dt);
+    // Start the next interval
+    void reset();
+
+    // Physics steps since the last reset, the summaries below need at least one
+    unsigned int getSteps() const { return steps_; }
+    float getMean(size_t k) const { return sum_[k] / static_cast<float>(steps_); }
+    float getMin(size_t k) const { return min_[k]; }
+    float getMax(size_t k) const { return max_[k]; }
+    float getIntegral(size_t k) const { return integral_[k]; }  // sum of value * dt
+
+private:
+    std::vector<float> sum_;
+    std::vector<float> integral_;
+    std::vector<float> min_;
+    std::vector<float> max_;
+    unsigned int steps_ = 0;
+};
+
+#endif // SUBSTEPACCUMULATORS_H
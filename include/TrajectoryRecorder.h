@@ -0,0 +1,91 @@
+#ifndef TRAJECTORYRECORDER_H
+#define TRAJECTORYRECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr uint32_t TRAJ_FLAG_RESET = 1 << 0;    // first row of an episode (observation after a reset)
+constexpr uint32_t TRAJ_FLAG_DONE = 1 << 1;     // last row of an episode
+
+// Offline dataset recorder. The step loop pushes one row per observation reply into a
+// lock-free single producer/single consumer ring and never waits: when the ring is full
+// the row is dropped and counted. The newest row is held back until the next one, so a
+// reset can still mark it as the last of its episode. A background thread writes the rows in chunks to one
+// flat file per column plus index.json, so every column opens with np.memmap as is:
+//   DIR/index.json, sim_time.bin (f8), step.bin (u4), flags.bin (u4), reward.bin (f4),
+//   observation.bin (f4, rows x O), action.bin (f4, rows x A)
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder() = default;
+    ~TrajectoryRecorder();
+    
+    bool open(const std::string& directory, const std::vector<std::string>& observation_names,
+              const std::vector<std::string>& action_names, size_t ring_rows = 1 << 16, size_t chunk_rows = 4096);
+    
+    // Writes the rows still in the ring and joins the writer thread
+    void close();
+    bool isOpen() const { return writer_.joinable(); }
+    
+    // Producer side (step loop thread only). False if the row was dropped. A TRAJ_FLAG_RESET row
+    // also sets TRAJ_FLAG_DONE on the previous row, with or without reward config
+    bool record(const float* observation, const float* action, float reward, uint32_t flags, double sim_time);
+    
+    // Rows accepted by record() / rows already in the column files
+    uint64_t getAcceptedCount() const { return accepted_; }
+    uint64_t getRecordedCount() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    const std::string& getDirectory() const { return directory_; }
+
+private:
+    struct Column {
+        std::string name;
+        std::string dtype;      // numpy dtype string
+        size_t width;           // values per row
+        size_t value_size;      // bytes per value
+        FILE* file = nullptr;
+        std::vector<char> chunk;
+    };
+    
+    // Ring slot: sim_time, step, flags, reward, observation, action
+    struct RowHeader {
+        double sim_time;
+        uint32_t step;
+        uint32_t flags;
+        float reward;
+        uint32_t pad;
+    };
+    
+    std::string directory_;
+    std::vector<std::string> observation_names_;
+    std::vector<std::string> action_names_;
+    size_t obs_size_ = 0;
+    size_t action_size_ = 0;
+    
+    std::vector<char> ring_;
+    size_t ring_mask_ = 0;
+    size_t slot_size_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};   // written by the producer
+    alignas(64) std::atomic<size_t> tail_{0};   // written by the writer thread
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<bool> running_{false};
+    uint32_t episode_step_ = 0;                 // producer only
+    bool staged_ = false;                       // producer only, the row in slot head_ is not published yet
+    uint64_t accepted_ = 0;                     // producer only
+    
+    std::vector<Column> columns_;
+    size_t chunk_rows_ = 0;
+    size_t chunk_fill_ = 0;
+    std::thread writer_;
+    
+    void writerLoop();
+    void appendRow(const char* slot);
+    void flushChunk();
+    void writeIndex();
+};
+
+#endif // TRAJECTORYRECORDER_H
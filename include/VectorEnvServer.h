@@ -0,0 +1,68 @@
+#ifndef VECTORENVSERVER_H
+#define VECTORENVSERVER_H
+
+#include "ZMQCommunicator.h"
+#include "CommonTypes.h"
+#include <zmq.hpp>
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <vector>
+#include <string>
+
+// Serves N environments as one batched endpoint. Stonefish keeps process-wide state
+// (SimulationApp::getApp(), ocean, materials), so every environment is a separate headless
+// StonefishRLTest process running the normal learning loop; this server only fans each
+// batch out to them and gathers the replies: N x A actions in, N x O observations out
+// (row per environment). All environments step at the same time, one per process.
+class VectorEnvServer {
+public:
+    // worker_endpoints: one bound StonefishRLTest per environment, address: client endpoint
+    VectorEnvServer(const std::vector<std::string>& worker_endpoints, const std::string& address, int ready_timeout_ms = 120000);
+
+    // False if a worker did not answer HELLO or the workers do not share one layout
+    bool isReady() const { return ready_; }
+
+    // Serve requests until EXIT (also sent to every worker)
+    void Run();
+
+    const std::string& getEndpoint() const { return communicator_.getEndpoint(); }
+
+private:
+    // Declared before the sockets, so it is destroyed after them
+    zmq::context_t context_;
+    std::vector<zmq::socket_t> workers_;     // REQ, one per environment
+    ZMQCommunicator communicator_;
+    bool ready_ = false;
+    nlohmann::json layout_;                  // HELLO layout of the workers
+    size_t obs_size_ = 0;
+    size_t action_size_ = 0;
+    unsigned int max_substeps_ = 0;          // action config bound of the workers
+    bool outcome_ = false;                   // workers have a reward config
+    std::vector<uint32_t> snapshot_slots_;   // per environment, bit per filled snapshot slot
+    uint32_t reply_sequence_ = 0;
+    double sim_time_ = 0.0;                  // clock of environment 0
+
+    // Batch buffers, row per environment
+    std::vector<float> observations_;        // num_envs x obs_size
+    std::vector<float> outcomes_;            // num_envs x [reward, terminated, truncated]
+    std::vector<std::string> reset_info_;    // reset JSON of the last reply of each environment
+    std::string trailer_;                    // outcomes and reset info after the observations
+    std::vector<char> frame_;                // action frame sent to one worker
+
+    bool connectWorkers(const std::vector<std::string>& worker_endpoints, int ready_timeout_ms);
+    // Send one request per selected worker, then gather the replies (the workers run in parallel).
+    // Every reply goes to handle_reply; without one it must be an observation and fills the worker's row
+    using ReplyHandler = std::function<bool(size_t, const zmq::message_t&)>;
+    bool exchange(const std::vector<bool>& selected, const std::function<zmq::const_buffer(size_t)>& request,
+                  const ReplyHandler& handle_reply = nullptr);
+    bool readObservation(size_t index, const zmq::message_t& reply);
+    bool parseTargets(const std::string& target, std::vector<bool>& selected) const;
+
+    bool handleStep(const zmq::message_t& msg);
+    bool handleReset(const std::string& args);
+    bool handleSnapshot(const std::string& args);
+    bool handleRestore(const std::string& args);
+    void sendBatch(uint16_t flags);
+};
+
+#endif // VECTORENVSERVER_H
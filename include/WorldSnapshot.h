@@ -0,0 +1,65 @@
+#ifndef WORLDSNAPSHOT_H
+#define WORLDSNAPSHOT_H
+
+#include <Stonefish/core/SimulationManager.h>
+#include <Stonefish/actuators/Servo.h>
+#include <Stonefish/actuators/Thruster.h>
+#include <Stonefish/sensors/Sensor.h>
+#include <vector>
+
+// Dynamic state of the whole world, captured and restored in place on the existing
+// Bullet objects (no scene reload). Restoring replaces a per-episode RESET.
+// Not captured: the thruster rotor speed (Stonefish has no setter, the rotor spins up again
+// towards the restored setpoint) and the servo control mode (servos keep their current
+// mode, with the captured position and zero velocity as targets).
+class WorldSnapshot {
+public:
+    WorldSnapshot() = default;
+    
+    void capture(sf::SimulationManager* sim);
+    void restore(sf::SimulationManager* sim);
+    
+    bool isValid() const { return valid_; }
+    void clear();
+
+private:
+    struct RigidBodyState {
+        btRigidBody* body;
+        btTransform transform;
+        btVector3 linear_velocity;
+        btVector3 angular_velocity;
+    };
+    
+    // Featherstone multibody: base state plus all joint positions and velocities
+    struct MultiBodyState {
+        btMultiBody* body;
+        btTransform base_transform;
+        btVector3 base_velocity;
+        btVector3 base_omega;
+        std::vector<btScalar> q;    // m_posVarCount values per link
+        std::vector<btScalar> qd;   // m_dofCount values per link
+    };
+    
+    struct ThrusterState {
+        sf::Thruster* thruster;
+        sf::Scalar setpoint;
+    };
+    
+    struct ServoState {
+        sf::Servo* servo;
+        sf::Scalar position;
+    };
+    
+    bool valid_ = false;
+    std::vector<RigidBodyState> rigid_bodies_;
+    std::vector<MultiBodyState> multibodies_;
+    std::vector<ThrusterState> thrusters_;
+    std::vector<ServoState> servos_;
+    std::vector<sf::Sensor*> sensors_;
+    
+    // Scratch buffers for the multibody forward kinematics after a restore
+    btAlignedObjectArray<btQuaternion> scratch_q_;
+    btAlignedObjectArray<btVector3> scratch_m_;
+};
+
+#endif // WORLDSNAPSHOT_H
@@ -1,13 +1,30 @@
 #ifndef ZMQCOMMUNICATOR_H
 #define ZMQCOMMUNICATOR_H
 
+#include "CommonTypes.h"
 #include <zmq.hpp>
 #include <string>
 #include <vector>
+#include <atomic>
+
+// REPLY: strict REQ/REP lockstep. ROUTER: the client (DEALER) may queue several
+// requests, they are served in order and every reply goes back to the sender
+enum class SocketMode {
+    REPLY,
+    ROUTER
+};
 
 class ZMQCommunicator {
 public:
-    ZMQCommunicator(const std::string& address = "tcp://*:5555");
+    // Any ZMQ endpoint: tcp://host:port (port "*" or 0 picks a free one), ipc://path, inproc://name
+    ZMQCommunicator(const std::string& address = "tcp://*:5555", SocketMode mode = SocketMode::REPLY);
+    
+    // Resolved endpoint after bind (e.g. the assigned port), empty if binding failed
+    const std::string& getEndpoint() const { return endpoint_; }
+    bool isBound() const { return !endpoint_.empty(); }
+    
+    // inproc:// endpoints only work inside one ZMQ context, in-process clients must connect through this one
+    static zmq::context_t& sharedContext();
     
     // Send methods for different data types
     template<typename T>
@@ -22,6 +39,10 @@ public:
     // Send JSON string (simple wrapper)
     void sendJson(const std::string& json_str);
 
+    // Send a binary observation reply (header + float32 values) as a zero-copy message
+    void sendObservationFrame(const ObservationHeader& header, const float* values, size_t count,
+                              const void* trailer = nullptr, size_t trailer_size = 0);
+
     // Receive methods
     zmq::message_t receive();
     bool receive(zmq::message_t& msg, zmq::recv_flags flags = zmq::recv_flags::none);
@@ -29,8 +50,30 @@ public:
     ~ZMQCommunicator();
 
 private:
+    // Reply buffers handed to ZMQ without copying. ZMQ releases them through
+    // releaseFrame() once sent, so a buffer is only rewritten when it is free.
+    // Declared before the context and socket: members are destroyed in reverse
+    // order, so the buffers outlive any release callback run during shutdown
+    struct FrameBuffer {
+        std::vector<char> data;
+        std::atomic<bool> in_flight{false};
+    };
+    FrameBuffer frame_buffers_[2];
+    int next_frame_ = 0;
+
     zmq::context_t context;
     zmq::socket_t socket;
+    std::string endpoint_;
+    SocketMode mode_;
+    
+    // ROUTER mode: routing id of the last request and whether it had an empty delimiter frame (REQ clients)
+    std::string peer_id_;
+    bool peer_delimiter_ = false;
+    
+    // Prefix the routing envelope of the last request (no-op in REPLY mode)
+    void sendEnvelope();
+
+    static void releaseFrame(void* data, void* hint);
 };
 
 #endif // ZMQCOMMUNICATOR_H
\ No newline at end of file
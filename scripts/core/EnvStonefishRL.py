@@ -1,16 +1,77 @@
+import sys
 import zmq
 import json
 import gymnasium as gym
 import numpy as np
 
+from core.shm_transport import SharedMemoryClient
+from core.launch_stonefish import global_path
+
+
+# Header of a binary observation reply (see ObservationHeader in CommonTypes.h)
+OBS_HEADER_DTYPE = np.dtype([
+    ("magic", "<u4"),
+    ("version", "<u2"),
+    ("flags", "<u2"),
+    ("sequence", "<u4"),
+    ("count", "<u4"),
+    ("sim_time", "<f8"),
+])
+OBS_MAGIC = 0x4C524653
+OBS_VERSION = 1
+OBS_FLAG_RESET = 1 << 0
+OBS_FLAG_OUTCOME = 1 << 2
+OBS_FLAG_RESET_INFO = 1 << 3
+
+# Header of a binary action frame (see ActionFrameHeader in CommonTypes.h)
+ACTION_FRAME_DTYPE = np.dtype([
+    ("magic", "<u4"),
+    ("version", "<u2"),
+    ("substeps", "<u2"),
+    ("count", "<u4"),
+    ("sequence", "<u4"),
+])
+ACTION_FRAME_MAGIC = 0x41524653
+
+
+def import_native_module():
+    """stonefish_rl_native, built with -DSTONEFISH_RL_PYTHON=ON next to StonefishRLTest"""
+    try:
+        import stonefish_rl_native
+    except ImportError:
+        sys.path.append(global_path("build"))
+        import stonefish_rl_native
+    return stonefish_rl_native
+
 
 class EnvStonefishRL(gym.Env):
 
-    def __init__(self, observation_config_path , action_config_path , ip="tcp://localhost:5555"):
+    def __init__(self, observation_config_path , action_config_path , ip="tcp://localhost:5555", substeps=None,
+                 binary_observations=False, transport="zmq", binary_actions=False, ready_timeout=60.0,
+                 async_mode=False, scene_path=None, resources_path=None, frequency=200.0):
         super().__init__()
-        self.context = zmq.Context()
-        self.socket = self.context.socket(zmq.REQ)
-        self.socket.connect(ip)
+        # transport="native" runs the simulator inside this process (scene_path and resources_path
+        # are then required, ip is ignored): no socket, no simulator process to launch
+        self.native = None
+        self.context = None
+        self.socket = None
+        if transport == "native":
+            if scene_path is None or resources_path is None:
+                raise ValueError("transport='native' needs scene_path and resources_path")
+            self.native = import_native_module().InProcessEnv(scene_path, resources_path, observation_config_path,
+                                                              action_config_path, frequency)
+            binary_observations = binary_actions = async_mode = False
+        else:
+            self.context = zmq.Context()
+            # Async mode talks to a simulator started with --async: several action frames can be
+            # in flight (step_async / recv_observation), replies carry the frame's sequence number
+            self.socket = self.context.socket(zmq.DEALER if async_mode else zmq.REQ)
+            self.socket.connect(ip)
+        self.async_mode = async_mode
+        self.pending_steps = 0
+        if async_mode:
+            binary_observations = True
+            binary_actions = True
 
         # Load configurations from JSON files
         self.observation_config = self._load_config(observation_config_path)
@@ -22,9 +83,47 @@ class EnvStonefishRL(gym.Env):
         
         self.observation_size = len(self.observation_names)
         self.action_size = len(self.action_names)
+
+        # Block until the simulator has built the scene (replaces fixed sleeps after launching it)
+        self.server_info = self.native.layout if self.native is not None else self.wait_ready(ready_timeout)
+        if self.server_info.get("observation_size") != self.observation_size \
+                or self.server_info.get("action_size") != self.action_size:
+            print(f"[WARNING] Simulator layout ({self.server_info.get('observation_size')} observations, "
+                  f"{self.server_info.get('action_size')} actions) does not match the config files")
+
+        # Physics steps each action is held for (None uses the action config default)
+        self.substeps = substeps
+        # Observation names (or entity names) requested after "OBS:" in CMD strings, None for all
+        self.observation_filter = None
         
         # Initialize state and spaces
         self.state = np.array([]) 
+        self.sim_time = 0.0
+        self.obs_sequence = 0
+        # (reward, terminated, truncated) of the last step when the observation config has a
+        # "reward_config" section (computed by the simulator), None otherwise
+        self.outcome = None
+        # Poses sampled by the simulator for the last reset (reset_config), None otherwise
+        self.reset_info = None
+        self.binary_observations = False
+        if binary_observations:
+            self._set_observation_format("BINARY")
+
+        # Binary action frames: header + one float32 per action spec, reused every step
+        self.binary_actions = binary_actions
+        self._action_frame = np.zeros(ACTION_FRAME_DTYPE.itemsize + 4 * self.action_size, dtype=np.uint8)
+        self._action_header = self._action_frame[:ACTION_FRAME_DTYPE.itemsize].view(ACTION_FRAME_DTYPE)
+        self._action_header["magic"] = ACTION_FRAME_MAGIC
+        self._action_header["version"] = OBS_VERSION
+        self._action_header["count"] = self.action_size
+        self._action_values = self._action_frame[ACTION_FRAME_DTYPE.itemsize:].view("<f4")
+
+        # Same-host shared memory transport for CMD steps (ZMQ stays the control channel)
+        self.shm = None
+        if transport == "shm":
+            self._open_shared_memory()
+        # Native steps write the observations into this buffer, env.state is a view on it
+        self._native_observations = np.zeros(self.server_info.get("observation_size", 0), dtype=np.float32)
         self.observation_space = None
         self.action_space = None
         
@@ -46,10 +145,26 @@ class EnvStonefishRL(gym.Env):
         """Extract observation names from observation config"""
         names = []
         try:
-            specs = self.observation_config.get("observation_config", {}).get("specs", [])
-            for spec in specs:
-                names.append(spec.get("output_name", "unknown_observation"))
-            return names
+            obs_config = self.observation_config.get("observation_config", {})
+            for spec in obs_config.get("specs", []):
+                name = spec.get("output_name", "unknown_observation")
+                # Sensor channel ranges give one value per channel, "name[i]"
+                channels = spec.get("channels", {})
+                count = max(1, int(channels.get("count", 1)))
+                if count > 1 or "start" in channels:
+                    names.extend(f"{name}[{k}]" for k in range(count))
+                else:
+                    names.append(name)
+            # Frame stacking done by the simulator: oldest frame first, "name@-k" k steps back
+            history = obs_config.get("history")
+            if not history:
+                return names
+            frame = list(names)
+            if history.get("actions", False):
+                frame += [spec.get("output_name", "unknown_action")
+                          for spec in self.action_config.get("action_config", {}).get("specs", [])]
+            length = max(1, int(history.get("length", 1)))
+            return [name + (f"@-{lag}" if lag else "") for lag in range(length - 1, -1, -1) for name in frame]
         except Exception as e:
             print(f"[ERROR] Failed to parse observation names: {e}")
             return []
@@ -67,11 +182,104 @@ class EnvStonefishRL(gym.Env):
             print(f"[ERROR] Failed to parse action names: {e}")
             return []
 
+    def wait_ready(self, timeout=60.0):
+        """HELLO handshake, returns the observation/action layout reported by the simulator"""
+        self.socket.send_string("HELLO")
+        if not self.socket.poll(int(timeout * 1000), zmq.POLLIN):
+            raise TimeoutError(f"Simulator did not answer HELLO within {timeout} s")
+        info = json.loads(self.socket.recv_string())
+        if info.get("status") != "READY":
+            raise RuntimeError(f"Unexpected handshake reply: {info}")
+        return info
+
+    def _set_observation_format(self, fmt):
+        """Negotiate the observation reply format (JSON or BINARY) with C++"""
+        self._send_control(f"FORMAT:{fmt}")
+        response = self.socket.recv_string()
+        if response != "FORMAT OK":
+            print(f"[ERROR] Simulator rejected observation format {fmt}: {response}")
+            return False
+        self.binary_observations = (fmt == "BINARY")
+        return True
+
+    def _open_shared_memory(self):
+        """Ask C++ for a shared memory segment and attach to it"""
+        self._send_control("SHM:OPEN")
+        response = self.socket.recv_string().split()
+        if len(response) != 5 or response[:2] != ["SHM", "OK"]:
+            print(f"[ERROR] Shared memory transport not available: {' '.join(response)}")
+            return False
+        self.shm = SharedMemoryClient(response[2])
+        print(f"[ENV] Shared memory transport: {response[2]} ({response[3]} observations, {response[4]} actions)")
+        return True
+
+    def _close_shared_memory(self):
+        """Send the simulator back to ZMQ steps and unmap the segment"""
+        self._send_control("SHM:CLOSE")
+        response = self.socket.recv_string()
+        if response != "SHM OK":
+            print(f"[ERROR] Simulator did not close the shared memory segment: {response}")
+        self.shm.close()
+        self.shm = None
+
+    def _send_control(self, message):
+        """Send a text request through ZMQ, the reply is read by the caller"""
+        # A DEALER socket delivers replies in order: the queued action frames are answered first
+        while self.pending_steps > 0:
+            self.recv_observation()
+        if self.shm is not None:
+            # The simulator sleeps on the shared memory doorbell until rung
+            self.shm.notify_control()
+        self.socket.send_string(message)
+
+    def _process_binary_observation(self, frame):
+        """Process binary observation frame (header + float32 values) from C++"""
+        buf = frame.buffer if isinstance(frame, zmq.Frame) else frame
+        header = np.frombuffer(buf, dtype=OBS_HEADER_DTYPE, count=1)[0]
+        if header["magic"] != OBS_MAGIC or header["version"] != OBS_VERSION:
+            print(f"[ERROR] Invalid observation frame (magic {header['magic']:#x}, version {header['version']})")
+            self.state = np.array([], dtype=np.float32)
+            return self.state
+
+        count = int(header["count"])
+        if count != self.observation_size and not self.observation_filter:
+            print(f"[WARNING] Observation size mismatch: expected {self.observation_size}, got {count}")
+
+        self.obs_sequence = int(header["sequence"])
+        self.sim_time = float(header["sim_time"])
+        # View on the received ZMQ frame, no parsing or copy
+        self.state = np.frombuffer(buf, dtype="<f4", count=count, offset=OBS_HEADER_DTYPE.itemsize)
+        self.outcome = None
+        offset = OBS_HEADER_DTYPE.itemsize + 4 * count
+        if int(header["flags"]) & OBS_FLAG_OUTCOME:
+            trailer = np.frombuffer(buf, dtype="<f4", count=3, offset=offset)
+            self.outcome = (float(trailer[0]), bool(trailer[1]), bool(trailer[2]))
+            offset += 12
+        if int(header["flags"]) & OBS_FLAG_RESET_INFO:
+            length = int(np.frombuffer(buf, dtype="<u4", count=1, offset=offset)[0])
+            self.reset_info = json.loads(bytes(buf[offset + 4:offset + 4 + length]))
+        return self.state
+
     def _process_observation_vector(self, msg):
         """Process observation vector from C++"""
+        if self.native is not None:
+            # Already the observation array (see _native_command)
+            self.state = msg
+            return self.state
+        if self.binary_observations:
+            return self._process_binary_observation(msg)
         try:
             obs_vector = json.loads(msg)
-            if len(obs_vector) != self.observation_size:
+            self.outcome = None
+            if isinstance(obs_vector, dict):
+                if "reward" in obs_vector:
+                    reward = obs_vector["reward"]  # null for a NaN/inf reward
+                    self.outcome = (float("nan") if reward is None else float(reward), bool(obs_vector["terminated"]),
+                                    bool(obs_vector["truncated"]))
+                if "reset" in obs_vector:
+                    self.reset_info = obs_vector["reset"]
+                obs_vector = obs_vector["observation"]
+            if len(obs_vector) != self.observation_size and not self.observation_filter:
                 print(f"[WARNING] Observation size mismatch: expected {self.observation_size}, got {len(obs_vector)}")
             
             self.state = np.array(obs_vector, dtype=np.float32)
@@ -90,6 +298,8 @@ class EnvStonefishRL(gym.Env):
             return "CMD:;OBS:"
         
         parts = []
+        if self.substeps is not None:
+            parts.append(f"STEPS:{int(self.substeps)}")
         try:
             specs = self.action_config.get("action_config", {}).get("specs", [])
             for i, (spec, action_value) in enumerate(zip(specs, action_vector)):
@@ -97,22 +307,137 @@ class EnvStonefishRL(gym.Env):
                 action_type = spec.get("action_type", "setpoint")
                 parts.append(f"{actuator_name}:{action_type}:{action_value}")
                 
-            return "CMD:" + ";".join(parts) + ";OBS:"
+            obs = ";".join(self.observation_filter) if self.observation_filter else ""
+            return "CMD:" + ";".join(parts) + ";OBS:" + obs
             
         except Exception as e:
             print(f"[ERROR] Failed to build command: {e}")
             return "CMD:;OBS:"
 
+    def set_observation_filter(self, names=None):
+        """Only reply the given observations (output or entity names, in config order) to CMD steps.
+
+        The simulator caches the compiled filter, keep the same list between steps. Binary action
+        frames and shared memory steps always reply every observation.
+        """
+        self.observation_filter = list(names) if names else None
+
+    def _fill_action_frame(self, action_vector):
+        self._action_values[:] = np.asarray(action_vector, dtype=np.float32).ravel()
+        self._action_header["substeps"] = self.substeps or 0
+        self._action_header["sequence"] += 1
+        return int(self._action_header["sequence"][0])
+
+    def send_action_frame(self, action_vector):
+        """Send a binary action frame (action config order) and return the reply"""
+        self._fill_action_frame(action_vector)
+        self.socket.send(self._action_frame, copy=False)
+        if self.binary_observations:
+            return self.socket.recv(copy=False)
+        return self.socket.recv_string()
+
+    def step_async(self, action_vector):
+        """Queue an action frame without waiting for its observation (async mode), returns its sequence"""
+        sequence = self._fill_action_frame(action_vector)
+        # Copied: the frame buffer is rewritten while earlier frames may still be queued
+        self.socket.send(self._action_frame, copy=True)
+        self.pending_steps += 1
+        return sequence
+
+    def recv_observation(self):
+        """Observation of the oldest queued action frame (async mode), returns (sequence, observation)"""
+        msg = self.socket.recv(copy=False)
+        self.pending_steps -= 1
+        self._process_binary_observation(msg)
+        return self.obs_sequence, self.state
+
     def send_command(self, message):
         """Send command to StonefishRL simulator"""
+        if self.native is not None:
+            return self._native_command(message)
         print(f"[CONN] Sending command: {message}")
-        self.socket.send_string(message)
+        self._send_control(message)
+        if self.binary_observations and message != "EXIT":
+            # Binary replies are kept as ZMQ frames and decoded without copying
+            response = self.socket.recv(copy=False)
+            print(f"[CONN] Response received: {len(response)} bytes")
+            return response
         response = self.socket.recv_string()
         print(f"[CONN] Response received: {len(response)} chars")
         return response
 
+    def _native_command(self, message):
+        """RESET/RESTORE/EXIT on the in-process simulator, the reply is the observation array"""
+        prefix, _, payload = message.partition(":")
+        if prefix == "RESET":
+            self.state = self.native.reset(payload, self._native_observations)
+            self.reset_info = self.native.reset_info
+        elif prefix == "RESTORE":
+            observations = self.native.restore(int(payload or 0), self._native_observations)
+            if observations is None:
+                print(f"[ERROR] Snapshot slot {payload} is empty")
+                return self.state
+            self.state = observations
+        elif prefix == "EXIT":
+            return "EXIT OK"
+        else:
+            print(f"[ERROR] Command not available with transport='native': {prefix}")
+            return self.state
+        self._read_native_outcome()
+        return self.state
+
+    def get_stats(self, reset=False):
+        """Step phase latencies (p50/p90/p99/max in us) and steps/s measured by C++"""
+        if self.native is not None:
+            return self.native.stats(reset)
+        self._send_control("STATS:RESET" if reset else "STATS")
+        return json.loads(self.socket.recv_string())
+
+    def snapshot(self, slot=0):
+        """Save the whole world state into a C++ snapshot slot (slot 0 holds the state after loading the scene)"""
+        if self.native is not None:
+            return self.native.snapshot(slot)
+        self._send_control(f"SNAPSHOT:{slot}")
+        return self.socket.recv_string().startswith("SNAPSHOT OK")
+
+    def restore(self, slot=0):
+        """Exact reset to a snapshot slot, returns the observation of the restored state"""
+        response = self.send_command(f"RESTORE:{slot}")
+        self._process_observation_vector(response)
+        return self.state
+
+    def start_trajectory(self, directory):
+        """Record every step into an offline dataset (open it with core.trajectory_dataset.load_trajectory)"""
+        return self._trajectory_command(f"TRAJ:START:{directory}")
+
+    def stop_trajectory(self):
+        return self._trajectory_command("TRAJ:STOP")
+
+    def trajectory_status(self):
+        """{"recording", "directory", "rows", "written", "dropped"}, rows lost because the writer fell behind are counted in dropped"""
+        return self._trajectory_command("TRAJ")
+
+    def _trajectory_command(self, command):
+        if self.native is not None:
+            print("[ERROR] Trajectory recording needs a ZMQ transport")
+            return None
+        self._send_control(command)
+        response = self.socket.recv_string()
+        if response == "TRAJ ERROR":
+            print("[ERROR] Trajectory recorder command failed")
+            return None
+        return json.loads(response)
+
     def close(self):
         """Close environment"""
+        if self.native is not None:
+            # Releases the in-process simulator now, a new one may be created afterwards
+            self.native.close()
+            self.native = None
+            print("[INFO] SIMULATION ENDED.")
+            return
+        if self.shm is not None:
+            self._close_shared_memory()
         _ = self.send_command("EXIT")
         self.socket.close()
         self.context.term()
@@ -121,7 +446,14 @@ class EnvStonefishRL(gym.Env):
     def reset(self, seed=None, options=None):
         """Reset environment"""
         try:
-            reset_command = "RESET:{}"
+            # Seeds np_random, every reset seed below is drawn from it
+            super().reset(seed=seed)
+            # A simulator with a reset_config samples the poses itself, from a seed of np_random
+            if self.server_info.get("reset_sampling"):
+                reset_command = "RESET:" + str(int(self.np_random.integers(2**63)))
+            else:
+                reset_command = "RESET:{}"
+            self.reset_info = None
             response = self.send_command(reset_command)
             self._process_observation_vector(response)
             
@@ -144,8 +476,7 @@ class EnvStonefishRL(gym.Env):
                     dtype=np.float32
                 )
             
-            super().reset(seed=seed)
-            info = {}
+            info = {"reset": self.reset_info} if self.reset_info is not None else {}
             return self.state, info
             
         except Exception as e:
@@ -177,20 +508,45 @@ class EnvStonefishRL(gym.Env):
     def step(self, action):
         """Execute one environment step"""
         try:
-            message = self.build_command(action)
-            msg = self.send_command(message)
-            self._process_observation_vector(msg)
+            if self.native is not None:
+                # Physics runs in this process with the GIL released, observations land in a reused buffer
+                self.state = self.native.step(np.asarray(action, dtype=np.float32).ravel(), self._native_observations,
+                                              self.substeps or 0)
+                self._read_native_outcome()
+            elif self.shm is not None:
+                # Observations are a view on the shared segment, valid until the next step
+                self.state = self.shm.step(np.asarray(action, dtype=np.float32).ravel(), self.substeps or 0)
+                self.sim_time = self.shm.sim_time
+                self.obs_sequence = self.shm.obs_sequence
+                self.outcome = self.shm.outcome
+            elif self.binary_actions:
+                msg = self.send_action_frame(action)
+                self._process_observation_vector(msg)
+            else:
+                message = self.build_command(action)
+                msg = self.send_command(message)
+                self._process_observation_vector(msg)
             
-            reward = self._calculate_reward()
-            done = self._is_done()
+            # Reward and episode end from the simulator when it has a reward config
+            if self.outcome is not None:
+                reward, done, truncated = self.outcome
+            else:
+                reward = self._calculate_reward()
+                done = self._is_done()
+                truncated = False
             info = self._get_info()
             
-            return self.state, reward, done, False, info
+            return self.state, reward, done, truncated, info
             
         except Exception as e:
             print(f"[ERROR] Step failed: {e}")
             return self.state, 0.0, True, False, {}
 
+    def _read_native_outcome(self):
+        self.sim_time = self.native.sim_time
+        self.obs_sequence += 1
+        self.outcome = self.native.outcome
+
     def _calculate_reward(self):
         """Calculate reward - to be overridden by child classes"""
         return 0.0
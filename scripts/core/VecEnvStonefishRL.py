@@ -0,0 +1,189 @@
+import json
+
+import gymnasium as gym
+import numpy as np
+import zmq
+from gymnasium.vector import AutoresetMode, VectorEnv
+from gymnasium.vector.utils import batch_space
+
+from core.EnvStonefishRL import OBS_FLAG_OUTCOME, OBS_FLAG_RESET_INFO, OBS_HEADER_DTYPE, OBS_MAGIC, OBS_VERSION
+
+
+# Header of a batched step request (see BatchStepHeader in CommonTypes.h)
+BATCH_STEP_DTYPE = np.dtype([
+    ("magic", "<u4"),
+    ("version", "<u2"),
+    ("substeps", "<u2"),
+    ("num_envs", "<u4"),
+    ("action_size", "<u4"),
+])
+BATCH_STEP_MAGIC = 0x42524653
+
+
+class VecEnvStonefishRL(VectorEnv):
+    """N Stonefish environments hosted by one simulator started with --num-envs N.
+
+    Every step sends the N x A action matrix in one message and receives the
+    N x O observation matrix in one contiguous buffer. Finished sub-environments
+    are reset in the same step (gymnasium SAME_STEP autoreset).
+    """
+
+    metadata = {"autoreset_mode": AutoresetMode.SAME_STEP}
+
+    def __init__(self, observation_config_path, action_config_path, ip="tcp://localhost:5555", substeps=0,
+                 max_episode_steps=None):
+        self.context = zmq.Context()
+        self.socket = self.context.socket(zmq.REQ)
+        self.socket.connect(ip)
+
+        self.socket.send_string("HELLO")
+        self.server_info = json.loads(self.socket.recv_string())
+        if "num_envs" not in self.server_info:
+            raise RuntimeError(f"Simulator is not a vectorized server: {self.server_info}")
+        self.num_envs = int(self.server_info["num_envs"])
+        self.observation_size = int(self.server_info["observation_size"])
+        self.action_size = int(self.server_info["action_size"])
+
+        with open(action_config_path, "r") as f:
+            action_specs = json.load(f).get("action_config", {}).get("specs", [])
+        # Names of the compiled layout (HELLO), observation_config_path is no longer read: channel ranges,
+        # history frames and skipped specs always match the matrix the server sends
+        self.observation_names = list(self.server_info.get("observations", []))
+        self.action_names = [spec.get("output_name", "unknown_action") for spec in action_specs]
+
+        low = np.array([spec.get("min_value", -1.0) for spec in action_specs], dtype=np.float32)
+        high = np.array([spec.get("max_value", 1.0) for spec in action_specs], dtype=np.float32)
+        self.single_observation_space = gym.spaces.Box(-np.inf, np.inf, shape=(self.observation_size,), dtype=np.float32)
+        self.single_action_space = gym.spaces.Box(low=low, high=high, shape=(self.action_size,), dtype=np.float32)
+        self.observation_space = batch_space(self.single_observation_space, self.num_envs)
+        self.action_space = batch_space(self.single_action_space, self.num_envs)
+
+        # Request buffer: header + N x A actions, reused for every step
+        self._request = np.zeros(BATCH_STEP_DTYPE.itemsize + 4 * self.num_envs * self.action_size, dtype=np.uint8)
+        header = self._request[:BATCH_STEP_DTYPE.itemsize].view(BATCH_STEP_DTYPE)[0]
+        header["magic"] = BATCH_STEP_MAGIC
+        header["version"] = OBS_VERSION
+        header["substeps"] = substeps
+        header["num_envs"] = self.num_envs
+        header["action_size"] = self.action_size
+        self._actions = self._request[BATCH_STEP_DTYPE.itemsize:].view("<f4").reshape(self.num_envs, self.action_size)
+
+        self.max_episode_steps = max_episode_steps
+        self.step_counters = np.zeros(self.num_envs, dtype=np.int64)
+        self.sim_time = 0.0
+        self.outcomes = None  # N x [reward, terminated, truncated] when the simulator has a reward config
+        self.reset_info = None  # per env sampled reset of the last VRESET (None where not sampled)
+
+        print(f"[VECENV] {self.num_envs} environments: {self.observation_size} observations, {self.action_size} actions")
+
+    def _recv_batch(self):
+        """Receive an N x O observation matrix (view on the ZMQ frame)"""
+        return self._parse_batch(self.socket.recv(copy=False))
+
+    def _parse_batch(self, frame):
+        buf = frame.buffer
+        header = np.frombuffer(buf, dtype=OBS_HEADER_DTYPE, count=1)[0]
+        if header["magic"] != OBS_MAGIC or int(header["count"]) != self.num_envs * self.observation_size:
+            raise RuntimeError(f"Invalid batch reply ({len(buf)} bytes)")
+        self.sim_time = float(header["sim_time"])
+        count = int(header["count"])
+        flags = int(header["flags"])
+        offset = OBS_HEADER_DTYPE.itemsize + 4 * count
+        self.outcomes = None
+        if flags & OBS_FLAG_OUTCOME:
+            self.outcomes = np.frombuffer(buf, dtype="<f4", count=3 * self.num_envs,
+                                          offset=offset).reshape(self.num_envs, 3)
+            offset += 12 * self.num_envs
+        if flags & OBS_FLAG_RESET_INFO:
+            length = int(np.frombuffer(buf, dtype="<u4", count=1, offset=offset)[0])
+            self.reset_info = json.loads(bytes(buf[offset + 4:offset + 4 + length]))
+        return np.frombuffer(buf, dtype="<f4", count=count,
+                             offset=OBS_HEADER_DTYPE.itemsize).reshape(self.num_envs, self.observation_size)
+
+    def _reset_envs(self, mask):
+        """Reset the masked sub-environments with one VRESET and return the whole observation batch"""
+        indices = np.flatnonzero(mask)
+        payloads = [self.build_reset_command(i) if mask[i] else None for i in range(self.num_envs)]
+        target = "*" if indices.size == self.num_envs else ",".join(str(i) for i in indices)
+        self.reset_info = None
+        self.socket.send_string(f"VRESET:{target}:{json.dumps({'envs': payloads})}")
+        self.step_counters[mask] = 0
+        return self._recv_batch()
+
+    def reset(self, *, seed=None, options=None):
+        super().reset(seed=seed, options=options)
+        obs = self._reset_envs(np.ones(self.num_envs, dtype=np.bool_))
+        return obs.copy(), ({"reset": self.reset_info} if self.reset_info is not None else {})
+
+    def step(self, actions):
+        self._actions[:] = np.asarray(actions, dtype=np.float32).reshape(self.num_envs, self.action_size)
+        self.socket.send(self._request, copy=False)
+        obs = self._recv_batch()
+        self.step_counters += 1
+
+        if self.outcomes is not None:
+            # Computed by the simulator from the reward config
+            rewards = self.outcomes[:, 0].astype(np.float64)
+            terminations = self.outcomes[:, 1] > 0
+            truncations = self.outcomes[:, 2] > 0
+        else:
+            rewards = np.asarray(self._calculate_rewards(obs, actions), dtype=np.float64)
+            terminations = np.asarray(self._is_terminated(obs), dtype=np.bool_)
+            truncations = np.zeros(self.num_envs, dtype=np.bool_)
+        if self.max_episode_steps is not None:
+            truncations = truncations | (self.step_counters >= self.max_episode_steps)
+
+        obs = obs.copy()
+        infos = {}
+        done = terminations | truncations
+        if done.any():
+            # Last observation of the finished episodes, then one VRESET for all of them
+            infos["final_obs"] = np.where(done[:, None], obs, 0.0).astype(np.float32)
+            infos["_final_obs"] = done.copy()
+            infos["final_info"] = {}
+            infos["_final_info"] = done.copy()
+            obs[done] = self._reset_envs(done)[done]
+            if self.reset_info is not None:
+                infos["reset"] = self.reset_info
+
+        return obs, rewards, terminations, truncations, infos
+
+    def snapshot(self, slot=0):
+        """Save a world snapshot of every sub-environment into slot"""
+        self.socket.send_string(f"VSNAPSHOT:*:{slot}")
+        reply = self.socket.recv_string()
+        if reply != "VSNAPSHOT OK":
+            raise RuntimeError(f"Snapshot failed: {reply}")
+
+    def restore(self, slot=0):
+        """Restore every sub-environment to a snapshot slot and return the observation batch"""
+        self.socket.send_string(f"VRESTORE:*:{slot}")
+        frame = self.socket.recv(copy=False)
+        if len(frame.buffer) < OBS_HEADER_DTYPE.itemsize:
+            raise RuntimeError(f"Restore failed: {bytes(frame.buffer).decode(errors='replace')}")
+        self.step_counters[:] = 0
+        return self._parse_batch(frame).copy(), {}
+
+    def build_reset_command(self, index):
+        """Reset payload (list of robot poses) for one sub-environment - to be overridden by child classes.
+
+        A simulator with a reset_config samples the poses itself, from a seed drawn from np_random.
+        """
+        if self.server_info.get("reset_sampling"):
+            return int(self.np_random.integers(2**63))
+        return []
+
+    def _calculate_rewards(self, obs, actions):
+        """Rewards for the batch - to be overridden by child classes"""
+        return np.zeros(self.num_envs)
+
+    def _is_terminated(self, obs):
+        """Terminations for the batch - to be overridden by child classes"""
+        return np.zeros(self.num_envs, dtype=np.bool_)
+
+    def close_extras(self, **kwargs):
+        self.socket.send_string("EXIT")
+        self.socket.recv()
+        self.socket.close()
+        self.context.term()
+        print("[INFO] SIMULATION ENDED.")
@@ -0,0 +1,77 @@
+"""Step latency of the ZMQ REQ/REP path vs. the shared memory transport.
+
+Start the simulator first (e.g. with launch_stonefish_simulator) and run:
+    python3 scripts/core/bench_transport.py OBS_CONFIG ACTION_CONFIG [--steps N]
+"""
+import argparse
+import os
+import sys
+import time
+
+import numpy as np
+import zmq
+
+sys.path.append(os.path.abspath(os.path.join(os.path.dirname(__file__), "..")))
+from core.shm_transport import SharedMemoryClient
+from core.EnvStonefishRL import EnvStonefishRL
+
+
+def report(name, samples):
+    us = np.asarray(samples) * 1e6
+    print(f"{name:>6}: mean {us.mean():8.1f} us  p50 {np.percentile(us, 50):8.1f} us  "
+          f"p99 {np.percentile(us, 99):8.1f} us  ({1e6 / us.mean():8.0f} steps/s)")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("observation_config")
+    parser.add_argument("action_config")
+    parser.add_argument("--ip", default="tcp://localhost:5555")
+    parser.add_argument("--steps", type=int, default=2000)
+    args = parser.parse_args()
+
+    # Only used for the config parsing and command building
+    env = EnvStonefishRL.__new__(EnvStonefishRL)
+    env.substeps = None
+    env.action_config = EnvStonefishRL._load_config(env, args.action_config)
+    env.action_size = len(EnvStonefishRL._get_action_names(env))
+
+    context = zmq.Context()
+    socket = context.socket(zmq.REQ)
+    socket.connect(args.ip)
+    socket.send_string("RESET:[]")
+    socket.recv()
+
+    action = np.zeros(env.action_size, dtype=np.float32)
+
+    samples = []
+    for _ in range(args.steps):
+        t0 = time.perf_counter()
+        socket.send_string(env.build_command(action))
+        socket.recv()
+        samples.append(time.perf_counter() - t0)
+    report("zmq", samples)
+
+    socket.send_string("SHM:OPEN")
+    reply = socket.recv_string().split()
+    if reply[:2] != ["SHM", "OK"]:
+        print(f"[ERROR] Shared memory transport not available: {' '.join(reply)}")
+        return
+    shm = SharedMemoryClient(reply[2])
+    samples = []
+    for _ in range(args.steps):
+        t0 = time.perf_counter()
+        shm.step(action)
+        samples.append(time.perf_counter() - t0)
+    report("shm", samples)
+
+    shm.notify_control()
+    socket.send_string("SHM:CLOSE")
+    socket.recv()
+    shm.close()
+    socket.close()
+    context.term()
+
+
+if __name__ == "__main__":
+    main()
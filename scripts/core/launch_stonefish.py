@@ -1,7 +1,11 @@
 import subprocess
 import os
+import tempfile
 import time
 
+# Fixed endpoint of the simulator when no other one is given
+DEFAULT_ENDPOINT = "tcp://*:5555"
+
 def kill_existing_stonefish_processes():
     try:
         # # Find any process currently running StonefishRLTest
@@ -23,17 +27,71 @@ def global_path(relative_path):
 
     return os.path.join(project_root, relative_path)
 
-def launch_stonefish_simulator(scene_relative_path,resources_path, observation_config_path, action_config_path ):
+def connect_address(endpoint):
+    """Address a client connects to for a bound endpoint (wildcard hosts become localhost)"""
+    for wildcard in ("tcp://*:", "tcp://0.0.0.0:"):
+        if endpoint.startswith(wildcard):
+            return "tcp://localhost:" + endpoint[len(wildcard):]
+    return endpoint
+
+def wait_endpoint_file(path, process, timeout):
+    """Wait for the simulator to write its bound endpoint"""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if process.poll() is not None:
+            raise RuntimeError(f"Stonefish exited with code {process.returncode} before binding")
+        with open(path, "r") as f:
+            endpoint = f.read().strip()
+        if endpoint:
+            return endpoint
+        time.sleep(0.01)
+    raise TimeoutError(f"Stonefish did not report its endpoint within {timeout} s")
+
+def launch_stonefish_simulator(scene_relative_path,resources_path, observation_config_path, action_config_path, headless=None, num_envs=1,
+                               endpoint=None, timeout=60.0):
     """
     Launch the Stonefish simulator with the specified scene.
     scene_relative_path: path relative to the project root.
+    headless: run without window or rendering. If None, the STONEFISH_HEADLESS
+              environment variable is used (e.g. STONEFISH_HEADLESS=1).
+    num_envs: number of environments hosted by the simulator (use VecEnvStonefishRL when > 1).
+    endpoint: address the simulator binds. None keeps the fixed tcp://*:5555 (old simulators are
+              killed first). "tcp://127.0.0.1:*" picks a free port, "ipc:///tmp/NAME" uses a unix socket;
+              both allow several simulators per host.
+    Returns (process, address for the environment's ip argument). The environments wait for
+    the simulator with the HELLO handshake, so no sleep is needed after launching.
     """
-    # Make sure that there are no old Stonefish processes running
-    kill_existing_stonefish_processes()
+    if headless is None:
+        headless = os.environ.get("STONEFISH_HEADLESS", "0").lower() in ("1", "true", "yes")
+
+    if endpoint is None:
+        # Only the fixed port can collide with an old simulator
+        endpoint = DEFAULT_ENDPOINT
+        kill_existing_stonefish_processes()
     
     # Path to the Stonefish executable
     stonefish_exe = os.path.join( global_path("build") , "StonefishRLTest")
     
     # Run the scene
     print(f"[INFO] Executing Stonefish with the scene: {scene_relative_path}")
-    stonefish_proc = subprocess.Popen([stonefish_exe, scene_relative_path,resources_path, observation_config_path,action_config_path])
\ No newline at end of file
+    cmd = [stonefish_exe, scene_relative_path,resources_path, observation_config_path,action_config_path]
+    if headless:
+        cmd.append("--headless")
+    if num_envs > 1:
+        cmd += ["--num-envs", str(num_envs)]
+    cmd += ["--endpoint", endpoint]
+
+    # Automatic ports are only known once bound, the simulator writes them to a file
+    endpoint_file = None
+    if endpoint.endswith(":*") or endpoint.endswith(":0"):
+        fd, endpoint_file = tempfile.mkstemp(prefix="stonefish_endpoint_")
+        os.close(fd)
+        cmd += ["--endpoint-file", endpoint_file]
+
+    stonefish_proc = subprocess.Popen(cmd)
+    if endpoint_file is not None:
+        try:
+            endpoint = wait_endpoint_file(endpoint_file, stonefish_proc, timeout)
+        finally:
+            os.remove(endpoint_file)
+    return stonefish_proc, connect_address(endpoint)
\ No newline at end of file
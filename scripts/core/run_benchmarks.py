@@ -0,0 +1,61 @@
+"""Run StonefishRLBenchmark on the reference scenes and write one result file per scene.
+
+    python3 scripts/core/run_benchmarks.py OUTPUT_DIR [--label v1.2] [--steps N] [--async]
+
+Compare the files of two releases to spot protocol/transport regressions.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+sys.path.append(os.path.abspath(os.path.join(os.path.dirname(__file__), "..")))
+from core.launch_stonefish import global_path
+
+
+# (name, scene, observation config, action config)
+SCENES = [
+    ("minimal", "Resources/minimal/minimal_scene.xml",
+     "include/observations/minimal_observation_config.json", "include/observations/minimal_action_config.json"),
+    ("girona500_basic", "Resources/g500/scenarios/girona500_basic.scn",
+     "include/observations/observation_config.json", "include/observations/action_config.json"),
+    ("girona500_docking", "Resources/girona_ds/scenarios/girona500_docking_sim_pool.scn",
+     "include/observations/ds_observation_config.json", "include/observations/ds_action_config.json"),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("output_dir")
+    parser.add_argument("--label", default="")
+    parser.add_argument("--steps", type=int, default=2000)
+    parser.add_argument("--modes", default=None, help="comma separated, default: all")
+    parser.add_argument("--async", dest="async_mode", action="store_true", help="also run the pipelined mode")
+    args = parser.parse_args()
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    benchmark_exe = os.path.join(global_path("build"), "StonefishRLBenchmark")
+    failed = False
+    for name, scene, obs_config, action_config in SCENES:
+        output = os.path.join(args.output_dir, f"{name}.json")
+        cmd = [benchmark_exe, global_path(scene), global_path("./"), global_path(obs_config),
+               global_path(action_config), "--steps", str(args.steps), "--output", output, "--label", args.label]
+        if args.modes:
+            cmd += ["--modes", args.modes]
+        if args.async_mode:
+            cmd.append("--async")
+        print(f"[INFO] Benchmarking {name}")
+        if subprocess.run(cmd).returncode != 0:
+            failed = True
+        if os.path.exists(output):
+            with open(output) as f:
+                for result in json.load(f)["results"]:
+                    if result["ok"] and "skipped" not in result:
+                        print(f"  {result['mode']:>7}: {result['steps_per_s']:9.1f} steps/s  "
+                              f"p99 {result['latency_us']['p99']:8.1f} us")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,151 @@
+import ctypes
+import platform
+import time
+from multiprocessing import shared_memory, resource_tracker
+
+import numpy as np
+
+
+# Header of the shared memory segment (see SharedMemoryHeader in SharedMemoryTransport.h)
+SHM_HEADER_DTYPE = np.dtype([
+    ("magic", "<u4"),
+    ("version", "<u4"),
+    ("obs_capacity", "<u4"),
+    ("action_capacity", "<u4"),
+    ("request_seq", "<u4"),
+    ("reply_seq", "<u4"),
+    ("substeps", "<u4"),
+    ("obs_count", "<u4"),
+    ("sim_time", "<f8"),
+    ("obs_sequence", "<u4"),
+    ("flags", "<u4"),
+    ("reward", "<f4"),
+    ("outcome", "<u4"),
+    ("wake_seq", "<u4"),
+    ("control_seq", "<u4"),
+])
+SHM_MAGIC = 0x4D485346
+SHM_VERSION = 2
+SHM_FLAG_CLOSED = 1 << 0
+SHM_OUTCOME_VALID = 1 << 0
+SHM_OUTCOME_TERMINATED = 1 << 1
+SHM_OUTCOME_TRUNCATED = 1 << 2
+
+_REQUEST_SEQ_OFFSET = SHM_HEADER_DTYPE.fields["request_seq"][1]
+_REPLY_SEQ_OFFSET = SHM_HEADER_DTYPE.fields["reply_seq"][1]
+_WAKE_SEQ_OFFSET = SHM_HEADER_DTYPE.fields["wake_seq"][1]
+_CONTROL_SEQ_OFFSET = SHM_HEADER_DTYPE.fields["control_seq"][1]
+
+_FUTEX_WAIT = 0
+_FUTEX_WAKE = 1
+_SYS_FUTEX = {"x86_64": 202, "aarch64": 98}.get(platform.machine())
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+class SharedMemoryClient:
+    """Client side of the shared memory transport opened with 'SHM:OPEN'.
+
+    Observations are exposed as a numpy view on the segment (no copy), so
+    `observations` is overwritten by the next step. Copy it to keep it.
+    The simulator only listens to ZMQ when rung: call notify_control() before
+    every control request sent through the socket while the segment is open.
+    """
+
+    def __init__(self, name):
+        try:
+            self.shm = shared_memory.SharedMemory(name=name, create=False, track=False)
+        except TypeError:
+            # Python < 3.13, keep the resource tracker from unlinking the server segment
+            self.shm = shared_memory.SharedMemory(name=name, create=False)
+            resource_tracker.unregister(self.shm._name, "shared_memory")
+
+        self.header = np.ndarray((), dtype=SHM_HEADER_DTYPE, buffer=self.shm.buf)
+        if int(self.header["magic"]) != SHM_MAGIC or int(self.header["version"]) != SHM_VERSION:
+            raise RuntimeError(f"Invalid shared memory segment {name}")
+
+        obs_capacity = int(self.header["obs_capacity"])
+        action_capacity = int(self.header["action_capacity"])
+        offset = SHM_HEADER_DTYPE.itemsize
+        self._observations = np.ndarray((obs_capacity,), dtype="<f4", buffer=self.shm.buf, offset=offset)
+        self.actions = np.ndarray((action_capacity,), dtype="<f4", buffer=self.shm.buf,
+                                  offset=offset + 4 * obs_capacity)
+
+        # Doorbell words, accessed through ctypes so futex can address them
+        self._request_seq = ctypes.c_uint32.from_buffer(self.shm.buf, _REQUEST_SEQ_OFFSET)
+        self._reply_seq = ctypes.c_uint32.from_buffer(self.shm.buf, _REPLY_SEQ_OFFSET)
+        self._wake_seq = ctypes.c_uint32.from_buffer(self.shm.buf, _WAKE_SEQ_OFFSET)
+        self._control_seq = ctypes.c_uint32.from_buffer(self.shm.buf, _CONTROL_SEQ_OFFSET)
+        self._futex = None
+        if _SYS_FUTEX is not None:
+            libc = ctypes.CDLL(None, use_errno=True)
+            self._futex = libc.syscall
+
+    @property
+    def observations(self):
+        return self._observations[:int(self.header["obs_count"])]
+
+    @property
+    def sim_time(self):
+        return float(self.header["sim_time"])
+
+    @property
+    def obs_sequence(self):
+        return int(self.header["obs_sequence"])
+
+    @property
+    def outcome(self):
+        """(reward, terminated, truncated) computed by the server, None without reward config"""
+        bits = int(self.header["outcome"])
+        if not bits & SHM_OUTCOME_VALID:
+            return None
+        return (float(self.header["reward"]), bool(bits & SHM_OUTCOME_TERMINATED),
+                bool(bits & SHM_OUTCOME_TRUNCATED))
+
+    def step(self, action, substeps=0, timeout=10.0):
+        """Write the action, ring the doorbell and wait for the observations"""
+        self.actions[:] = action
+        self.header["substeps"] = substeps
+        seq = (self._request_seq.value + 1) & 0xFFFFFFFF
+        self._request_seq.value = seq
+        self._ring()
+
+        deadline = time.monotonic() + timeout
+        while True:
+            reply = self._reply_seq.value
+            if int(self.header["flags"]) & SHM_FLAG_CLOSED:
+                raise RuntimeError("Simulator closed the shared memory segment")
+            if reply == seq:
+                return self.observations
+            if time.monotonic() > deadline:
+                raise TimeoutError("No reply from simulator through shared memory")
+            self._wait(self._reply_seq, reply)
+
+    def notify_control(self):
+        """Wake the simulator up for a ZMQ control request (RESET, SHM:CLOSE, EXIT, ...)"""
+        self._control_seq.value = (self._control_seq.value + 1) & 0xFFFFFFFF
+        self._ring()
+
+    def _ring(self):
+        # This client is the only writer of the wake word
+        self._wake_seq.value = (self._wake_seq.value + 1) & 0xFFFFFFFF
+        self._wake(self._wake_seq)
+
+    def _wake(self, word):
+        if self._futex is not None:
+            self._futex(_SYS_FUTEX, ctypes.byref(word), _FUTEX_WAKE, 1, None, None, 0)
+
+    def _wait(self, word, expected):
+        if self._futex is not None:
+            ts = _Timespec(0, 1_000_000)
+            self._futex(_SYS_FUTEX, ctypes.byref(word), _FUTEX_WAIT, ctypes.c_uint32(expected), ctypes.byref(ts), None, 0)
+        else:
+            time.sleep(0)
+
+    def close(self):
+        # Release the buffer exports before closing the mapping
+        del self._request_seq, self._reply_seq, self._wake_seq, self._control_seq
+        self.header = self._observations = self.actions = None
+        self.shm.close()
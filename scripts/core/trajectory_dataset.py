@@ -0,0 +1,37 @@
+"""
+Open a trajectory dataset written by the simulator (TRAJ:START or --trajectory).
+
+Every column is a flat little-endian file, so it is memory-mapped as is:
+    index, data = load_trajectory("datasets/run_0")
+    data["observation"]     # (rows, O) float32, np.memmap
+    data["flags"] & TRAJ_FLAG_RESET   # first row of every episode
+"""
+import json
+import os
+
+import numpy as np
+
+TRAJ_FLAG_RESET = 1 << 0
+TRAJ_FLAG_DONE = 1 << 1
+
+
+def load_trajectory(directory, mode="r"):
+    """Return (index dict, {column name: np.memmap}) for the rows written so far"""
+    with open(os.path.join(directory, "index.json"), "r") as f:
+        index = json.load(f)
+
+    rows = int(index["num_rows"])
+    data = {}
+    for column in index["columns"]:
+        shape = (rows,) + tuple(column["shape"])
+        if rows == 0:
+            data[column["name"]] = np.zeros(shape, dtype=column["dtype"])
+            continue
+        data[column["name"]] = np.memmap(os.path.join(directory, column["file"]), dtype=column["dtype"],
+                                         mode=mode, shape=shape)
+    return index, data
+
+
+def episode_starts(data):
+    """Row indices where an episode starts"""
+    return np.flatnonzero(data["flags"] & TRAJ_FLAG_RESET)
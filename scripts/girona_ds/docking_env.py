@@ -52,10 +52,17 @@ class dsEnv(EnvStonefishRL):
 
     def reset(self, seed=None, options=None):
         """Reset environment"""
-        command = self.build_reset_command()
-        reset_command = "RESET:" + json.dumps(command) + ";"
+        # Seeds self.np_random
+        gym.Env.reset(self, seed=seed)
+        if self.server_info.get("reset_sampling"):
+            # Poses sampled by the simulator from the reset_config of the observation config
+            reset_command = f"RESET:{int(self.np_random.integers(0, 2**32))}"
+        else:
+            command = self.build_reset_command()
+            reset_command = "RESET:" + json.dumps(command) + ";"
         
         # Use parent reset but send our specific reset command
+        self.reset_info = None
         response = self.send_command(reset_command)
         self._process_observation_vector(response)
         
@@ -63,7 +70,7 @@ class dsEnv(EnvStonefishRL):
         self.last_action_applied = np.zeros(self.action_size, dtype=np.float32)
         
         obs = self.get_observation()
-        info = {}
+        info = {"reset": self.reset_info} if self.reset_info is not None else {}
         
         return obs, info
 
@@ -93,14 +100,17 @@ class dsEnv(EnvStonefishRL):
         # Use parent's step method
         obs, reward, terminated, truncated, info = super().step(action)
         
+        # With a "reward_config" in the observation config the simulator already scored the step
+        server_reward = self.outcome is not None
+        
         # Add application-specific termination conditions
-        if not terminated:
+        if not terminated and not server_reward:
             terminated = self._is_terminated()
         if not truncated:  
             truncated = self._is_truncated()
             
         # Add application-specific reward
-        additional_reward = self.calculate_additional_reward()
+        additional_reward = 0.0 if server_reward else self.calculate_additional_reward()
         total_reward = reward + additional_reward
         
         info.update(self._get_additional_info())
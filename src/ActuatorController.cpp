@@ -1,4 +1,5 @@
 #include "ActuatorController.h"
+#include <algorithm>
 
 void ActuatorController::applyCommands(const std::unordered_map<std::string, 
                                       std::unordered_map<std::string, float>>& commands,
@@ -39,6 +40,19 @@ void ActuatorController::applyCommands(const std::unordered_map<std::string,
             break;
         }
     }
+
+    // Keep the action vector view of the commands up to date
+    for (size_t i = 0; i < bound_actions_.size(); ++i) {
+        auto actuator_commands = commands.find(bound_actions_[i].actuator_name);
+        if (actuator_commands == commands.end()) continue;
+        auto value = actuator_commands->second.find(bound_actions_[i].action_type);
+        if (value != actuator_commands->second.end()) {
+            last_actions_[i] = value->second;
+            if (bound_actions_[i].mode == ActionMode::CONTROLLER_INPUT) {
+                *bound_actions_[i].input = value->second;
+            }
+        }
+    }
 }
 
 void ActuatorController::controlServo(sf::Servo* servo, const std::unordered_map<std::string, float>& actions) {
@@ -72,6 +86,90 @@ void ActuatorController::controlThruster(sf::Thruster* thruster, const std::unor
     }
 }
 
+void ActuatorController::bindActionSpecs(const ActionConfig& config, sf::SimulationManager* sim,
+                                         ControlPipeline* controllers) {
+    bound_actions_.assign(config.specs.size(), BoundAction());
+    last_actions_.assign(config.specs.size(), 0.0f);
+    size_t bound = 0;
+
+    for (size_t i = 0; i < config.specs.size(); ++i) {
+        const ActionSpec& spec = config.specs[i];
+        BoundAction& action = bound_actions_[i];
+        action.actuator_name = spec.actuator_name;
+        action.action_type = spec.action_type;
+        // Controller setpoints take precedence over actuators of the same name
+        action.input = controllers ? controllers->findInput(spec.actuator_name, spec.action_type) : nullptr;
+        if (action.input) {
+            action.mode = ActionMode::CONTROLLER_INPUT;
+            ++bound;
+            continue;
+        }
+        sf::Actuator* actuator_ptr = sim->getActuator(spec.actuator_name);
+        if (!actuator_ptr) {
+            std::cerr << "[ActuatorController] WARNING: Actuator not found for action " << i 
+                      << ": " << spec.actuator_name << std::endl;
+            continue;
+        }
+
+        // Same action keywords as the string commands
+        switch (actuator_ptr->getType()) {
+        case sf::ActuatorType::SERVO:
+            action.servo = dynamic_cast<sf::Servo *>(actuator_ptr);
+            if (action.servo && spec.action_type == "POSITION") {
+                action.mode = ActionMode::SERVO_POSITION;
+            } else if (action.servo && (spec.action_type == "VELOCITY" || spec.action_type == "TORQUE")) {
+                action.mode = ActionMode::SERVO_VELOCITY;
+            }
+            break;
+
+        case sf::ActuatorType::THRUSTER:
+            action.thruster = dynamic_cast<sf::Thruster *>(actuator_ptr);
+            if (action.thruster && (spec.action_type == "VELOCITY" || spec.action_type == "TORQUE")) {
+                action.mode = ActionMode::THRUSTER_SETPOINT;
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        if (action.mode == ActionMode::INVALID) {
+            std::cerr << "[ActuatorController] WARNING: Unsupported action '" << spec.action_type 
+                      << "' for actuator " << spec.actuator_name << std::endl;
+        } else {
+            ++bound;
+        }
+    }
+
+    std::cout << "[ActuatorController] Bound " << bound << "/" << config.specs.size() << " action specs" << std::endl;
+}
+
+void ActuatorController::applyActionVector(const float* values, size_t count) {
+    size_t n = std::min(count, bound_actions_.size());
+    std::copy(values, values + n, last_actions_.begin());
+    for (size_t i = 0; i < n; ++i) {
+        const BoundAction& action = bound_actions_[i];
+        switch (action.mode) {
+        case ActionMode::SERVO_POSITION:
+            action.servo->setControlMode(sf::ServoControlMode::POSITION);
+            action.servo->setDesiredPosition(values[i]);
+            break;
+        case ActionMode::SERVO_VELOCITY:
+            action.servo->setControlMode(sf::ServoControlMode::VELOCITY);
+            action.servo->setDesiredVelocity(values[i]);
+            break;
+        case ActionMode::THRUSTER_SETPOINT:
+            action.thruster->setSetpoint(values[i]);
+            break;
+        case ActionMode::CONTROLLER_INPUT:
+            *action.input = values[i];
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 void ActuatorController::printActuatorInfo(sf::SimulationManager* sim) {
     unsigned int id = 0;
     sf::Actuator *actuator_ptr;
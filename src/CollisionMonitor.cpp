@@ -0,0 +1,119 @@
+#include "CollisionMonitor.h"
+#include <algorithm>
+#include <iostream>
+
+void CollisionMonitor::configure(sf::SimulationManager* sim, const std::vector<sf::Robot*>& robots,
+                                 const std::vector<std::string>& targets) {
+    robots_.clear();
+    groups_.clear();
+    targets_ = targets;
+
+    for (sf::Robot* robot : robots) {
+        RobotContacts contacts;
+        contacts.name = robot->getName();
+        contacts.prefix = contacts.name + "/";
+        robots_.push_back(contacts);
+    }
+    if (robots_.empty()) return;
+
+    // Classify the scene entities now, robot link bodies are added on first contact
+    unsigned int id = 0;
+    sf::Entity* entity;
+    while ((entity = sim->getEntity(id++)) != nullptr) {
+        classify(entity);
+    }
+
+    std::cout << "[CollisionMonitor] Watching " << robots_.size() << " robots";
+    if (targets_.empty()) {
+        std::cout << " against any other body" << std::endl;
+    } else {
+        std::cout << " against " << targets_.size() << " target patterns" << std::endl;
+    }
+}
+
+int CollisionMonitor::classify(const sf::Entity* entity) {
+    auto it = groups_.find(entity);
+    if (it != groups_.end()) return it->second;
+
+    const std::string name = entity->getName();
+    int group = OTHER;
+    for (size_t i = 0; i < robots_.size(); ++i) {
+        if (name == robots_[i].name || name.compare(0, robots_[i].prefix.size(), robots_[i].prefix) == 0) {
+            group = static_cast<int>(i);
+            break;
+        }
+    }
+    if (group == OTHER) {
+        for (const auto& target : targets_) {
+            if (name.find(target) != std::string::npos) {
+                group = TARGET;
+                break;
+            }
+        }
+    }
+    groups_.emplace(entity, group);
+    return group;
+}
+
+bool CollisionMonitor::counts(int robot, int other) const {
+    if (robot < 0) return false;
+    if (targets_.empty()) return other != robot;
+    return other == TARGET;
+}
+
+void CollisionMonitor::update(sf::SimulationManager* sim) {
+    if (robots_.empty()) return;
+
+    for (auto& robot : robots_) {
+        robot.step_contacts = 0;
+        robot.step_impulse = 0.0f;
+    }
+
+    btDispatcher* dispatcher = sim->getDynamicsWorld()->getDispatcher();
+    int numManifolds = dispatcher->getNumManifolds();
+
+    for (int i = 0; i < numManifolds; ++i) {
+        btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+        int numContacts = manifold->getNumContacts();
+        if (numContacts == 0) continue;
+
+        const sf::Entity* entA = static_cast<const sf::Entity*>(manifold->getBody0()->getUserPointer());
+        const sf::Entity* entB = static_cast<const sf::Entity*>(manifold->getBody1()->getUserPointer());
+        if (!entA || !entB) continue;
+
+        int groupA = classify(entA);
+        int groupB = classify(entB);
+        bool countA = counts(groupA, groupB);
+        bool countB = counts(groupB, groupA);
+        if (!countA && !countB) continue;
+
+        float impulse = 0.0f;
+        for (int c = 0; c < numContacts; ++c) {
+            impulse += static_cast<float>(manifold->getContactPoint(c).getAppliedImpulse());
+        }
+        if (countA) {
+            robots_[groupA].step_contacts += numContacts;
+            robots_[groupA].step_impulse += impulse;
+        }
+        if (countB && groupB != groupA) {
+            robots_[groupB].step_contacts += numContacts;
+            robots_[groupB].step_impulse += impulse;
+        }
+    }
+
+    for (auto& robot : robots_) {
+        if (robot.step_contacts > 0) {
+            robot.collided = true;
+            robot.max_contacts = std::max(robot.max_contacts, static_cast<float>(robot.step_contacts));
+            robot.max_impulse = std::max(robot.max_impulse, robot.step_impulse);
+        }
+    }
+}
+
+void CollisionMonitor::beginInterval() {
+    for (auto& robot : robots_) {
+        robot.collided = false;
+        robot.max_contacts = 0.0f;
+        robot.max_impulse = 0.0f;
+    }
+}
@@ -1,22 +1,35 @@
 #include "CommandProcessor.h"
+#include <nlohmann/json.hpp>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 
 std::vector<RobotResetInfo> CommandProcessor::parseResetCommand(const std::string& command) {
     std::vector<RobotResetInfo> result;
-    size_t pos = 0;
-
-    // Find all objects in the format { ... }
-    while ((pos = command.find("{", pos)) != std::string::npos) {
-        size_t end = command.find("}", pos);
-        if (end == std::string::npos) break;
-        
-        std::string object_str = command.substr(pos, end - pos + 1);
-        RobotResetInfo obj = parseObjectFromJson(object_str);
-        result.push_back(obj);
-        
-        pos = end + 1;
+    
+    // "[{...}, {...}]" or a single "{...}", clients may close the payload with ';'
+    size_t end = command.find_last_not_of(" \t\r\n;");
+    if (end == std::string::npos) {
+        return result;
+    }
+    
+    try {
+        nlohmann::json j = nlohmann::json::parse(command.substr(0, end + 1));
+        if (j.is_object()) {
+            j = nlohmann::json::array({j});
+        }
+        for (const auto& item : j) {
+            // "{}" carries no robot, nothing to reposition
+            if (!item.is_object() || !item.contains("name")) continue;
+            RobotResetInfo info;
+            info.name = item["name"].get<std::string>();
+            info.position = item.value("position", std::vector<float>());
+            info.rotation = item.value("rotation", std::vector<float>());
+            result.push_back(info);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[CommandProcessor] Invalid RESET payload: " << e.what() << std::endl;
+        result.clear();
     }
     // debug output
     // std::cout << "[CommandProcessor] Parsed " << result.size() << " reset objects" << std::endl;
@@ -40,67 +53,25 @@ void CommandProcessor::parseActionCommands(const std::string& command) {
     std::string token;
     
     while (std::getline(ss, token, ';')) {
-        if (!token.empty()) {
+        if (token.empty()) {
+            continue;
+        }
+        // "STEPS:<n>" holds this action for n physics steps
+        if (token.compare(0, 6, "STEPS:") == 0) {
+            parseSubstepsToken(token);
+        } else {
             parseCommandToken(token);
         }
     }
 
-    // Parse observation filters
-    if (!obs_str.empty()) {
-        parseObservationFilter(obs_str);
-    }
+    // Observation filter, kept as text: StateManager compiles it once per distinct string
+    observation_filter_ = obs_str;
     /* Debug output 
-    std::cout << "[CommandProcessor] Parsed " << commands_.size() << " actuators, " 
-    << relevant_obs_names_.size() << " observation filters" << std::endl;
+    std::cout << "[CommandProcessor] Parsed " << commands_.size() << " actuators, filter '" 
+    << observation_filter_ << "'" << std::endl;
     */
 }
 
-RobotResetInfo CommandProcessor::parseObjectFromJson(const std::string& object_str) {
-    RobotResetInfo obj;
-    
-    // Parse name
-    size_t name_pos = object_str.find("\"name\"");
-    if (name_pos != std::string::npos) {
-        size_t start_quote = object_str.find("\"", name_pos + 6);
-        size_t end_quote = object_str.find("\"", start_quote + 1);
-        if (start_quote != std::string::npos && end_quote != std::string::npos) {
-            obj.name = object_str.substr(start_quote + 1, end_quote - start_quote - 1);
-        }
-    }
-
-    // Parse position
-    size_t pos_pos = object_str.find("\"position\"");
-    if (pos_pos != std::string::npos) {
-        size_t bracket_start = object_str.find("[", pos_pos);
-        size_t bracket_end = object_str.find("]", bracket_start);
-        if (bracket_start != std::string::npos && bracket_end != std::string::npos) {
-            std::string list = object_str.substr(bracket_start + 1, bracket_end - bracket_start - 1);
-            std::stringstream ss(list);
-            std::string val;
-            while (std::getline(ss, val, ',')) {
-                obj.position.push_back(std::stof(val));
-            }
-        }
-    }
-
-    // Parse rotation
-    size_t rot_pos = object_str.find("\"rotation\"");
-    if (rot_pos != std::string::npos) {
-        size_t bracket_start = object_str.find("[", rot_pos);
-        size_t bracket_end = object_str.find("]", bracket_start);
-        if (bracket_start != std::string::npos && bracket_end != std::string::npos) {
-            std::string list = object_str.substr(bracket_start + 1, bracket_end - bracket_start - 1);
-            std::stringstream ss(list);
-            std::string val;
-            while (std::getline(ss, val, ',')) {
-                obj.rotation.push_back(std::stof(val));
-            }
-        }
-    }
-
-    return obj;
-}
-
 void CommandProcessor::parseCommandToken(const std::string& token) {
     std::istringstream tokenStream(token);
     std::string actuator_name, action, action_value;
@@ -126,23 +97,22 @@ void CommandProcessor::parseCommandToken(const std::string& token) {
     }
 }
 
-void CommandProcessor::parseObservationFilter(const std::string& obs_str) {
-    std::istringstream obsStream(obs_str);
-    std::string obj_name;
-
-    while (std::getline(obsStream, obj_name, ';')) {
-        if (!obj_name.empty()) {
-            relevant_obs_names_.insert(obj_name);
-            std::cout << "[CommandProcessor] Observation filter: " << obj_name << std::endl;
+void CommandProcessor::parseSubstepsToken(const std::string& token) {
+    try {
+        int steps = std::stoi(token.substr(6));
+        if (steps < 1) {
+            std::cerr << "[CommandProcessor] Invalid STEPS value: '" << token << "', must be >= 1" << std::endl;
+            return;
         }
+        substeps_ = static_cast<unsigned int>(steps);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[CommandProcessor] Invalid STEPS value: '" << token << "': " << e.what() << std::endl;
     }
 }
 
 void CommandProcessor::clear() {
     commands_.clear();
-    relevant_obs_names_.clear();
+    observation_filter_.clear();
+    substeps_ = 0;
 }
-
-bool CommandProcessor::isObjectRelevant(const std::string& objectName) const {
-    return relevant_obs_names_.empty() || relevant_obs_names_.count(objectName) > 0;
-}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ConfigLoader.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -54,11 +55,7 @@ ObservationConfig ConfigLoader::parseJsonConfig(const nlohmann::json& j) {
             // Parse specs array
             if (obs_config.contains("specs")) {
                 for (const auto& spec_item : obs_config["specs"]) {
-                    ObservationSpec spec;
-                    spec.entity_name = spec_item.value("entity_name", "");
-                    spec.field_type = spec_item.value("field_type", "");
-                    spec.component = spec_item.value("component", "");
-                    spec.output_name = spec_item.value("output_name", "");
+                    ObservationSpec spec = parseObservationSpec(spec_item);
                     
                     if (!spec.entity_name.empty() && !spec.field_type.empty()) {
                         config.specs.push_back(spec);
@@ -68,16 +65,26 @@ ObservationConfig ConfigLoader::parseJsonConfig(const nlohmann::json& j) {
                     }
                 }
             }
+            
+            // Bodies that count as a collision for the "collision" specs (substring of the entity name)
+            if (obs_config.contains("collision") && obs_config["collision"].contains("targets")) {
+                for (const auto& target : obs_config["collision"]["targets"]) {
+                    config.collision_targets.push_back(target.get<std::string>());
+                }
+            }
+            
+            // Frame stacking: {"length": K, "actions": true}
+            if (obs_config.contains("history")) {
+                const auto& history = obs_config["history"];
+                config.history_length = std::max(1u, history.value("length", 1u));
+                config.history_actions = history.value("actions", false);
+            }
         }
         
         // If no observation_config found, try root level specs
         else if (j.contains("specs")) {
             for (const auto& spec_item : j["specs"]) {
-                ObservationSpec spec;
-                spec.entity_name = spec_item.value("entity_name", "");
-                spec.field_type = spec_item.value("field_type", "");
-                spec.component = spec_item.value("component", "");
-                spec.output_name = spec_item.value("output_name", "");
+                ObservationSpec spec = parseObservationSpec(spec_item);
                 
                 if (!spec.entity_name.empty() && !spec.field_type.empty()) {
                     config.specs.push_back(spec);
@@ -92,6 +99,36 @@ ObservationConfig ConfigLoader::parseJsonConfig(const nlohmann::json& j) {
     return config;
 }
 
+ObservationSpec ConfigLoader::parseObservationSpec(const nlohmann::json& j) {
+    ObservationSpec spec;
+    spec.entity_name = j.value("entity_name", "");
+    spec.field_type = j.value("field_type", "");
+    spec.component = j.value("component", "");
+    spec.output_name = j.value("output_name", "");
+    spec.aggregate = j.value("aggregate", "");
+    
+    if (j.contains("channels")) {
+        const auto& channels = j["channels"];
+        // Read signed and wide so negative or huge values are caught instead of wrapping
+        int64_t start = channels.value("start", int64_t(-1));
+        int64_t count = channels.value("count", int64_t(1));
+        int64_t stride = channels.value("stride", int64_t(1));
+        int64_t limit = MAX_SENSOR_CHANNELS;
+        if (start < -1 || start >= limit || count < 1 || count > limit || stride < 1 || stride > limit
+            || std::max<int64_t>(start, 0) + (count - 1) * stride >= limit) {
+            std::cerr << "[ConfigLoader] ERROR: Invalid channel range for " << spec.output_name 
+                      << " (start " << start << ", count " << count << ", stride " << stride 
+                      << ", channels below " << limit << "), spec skipped" << std::endl;
+            spec.field_type.clear();
+            return spec;
+        }
+        spec.channel_start = static_cast<int>(start);
+        spec.channel_count = static_cast<unsigned int>(count);
+        spec.channel_stride = static_cast<unsigned int>(stride);
+    }
+    return spec;
+}
+
 bool ConfigLoader::validateConfig(const ObservationConfig& config) {
     // Basic validation
     if (config.specs.empty()) {
@@ -128,4 +165,304 @@ ObservationConfig ConfigLoader::getDefaultConfig() {
               << config.specs.size() << " specs" << std::endl;
     
     return config;
-}
\ No newline at end of file
+}
+
+ActionConfig ConfigLoader::loadActionConfigFromFile(const std::string& filepath) {
+    try {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            std::cerr << "[ConfigLoader] ERROR: Cannot open action config file: " << filepath << std::endl;
+            return ActionConfig();
+        }
+        
+        nlohmann::json j;
+        file >> j;
+        return parseActionJsonConfig(j);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigLoader] ERROR: Failed to parse action config file '" << filepath 
+                  << "': " << e.what() << std::endl;
+        return ActionConfig();
+    }
+}
+
+ActionConfig ConfigLoader::parseActionJsonConfig(const nlohmann::json& j) {
+    ActionConfig config;
+    
+    try {
+        // Accept both {"action_config": {...}} and root level specs
+        const nlohmann::json& act_config = j.contains("action_config") ? j["action_config"] : j;
+        
+        int substeps = act_config.value("substeps", 1);
+        if (substeps < 1) {
+            std::cerr << "[ConfigLoader] WARNING: Invalid substeps " << substeps << ", using 1" << std::endl;
+            substeps = 1;
+        }
+        config.substeps = static_cast<unsigned int>(substeps);
+        
+        // A client request can hold the server for at most max_substeps physics steps
+        int max_substeps = act_config.value("max_substeps", static_cast<int>(config.max_substeps));
+        if (max_substeps < substeps) {
+            std::cerr << "[ConfigLoader] WARNING: max_substeps " << max_substeps << " is below substeps " 
+                      << substeps << ", using " << substeps << std::endl;
+            max_substeps = substeps;
+        }
+        config.max_substeps = static_cast<unsigned int>(max_substeps);
+        
+        if (act_config.contains("specs")) {
+            for (const auto& spec_item : act_config["specs"]) {
+                ActionSpec spec;
+                spec.actuator_name = spec_item.value("actuator_name", "");
+                spec.action_type = spec_item.value("action_type", "");
+                spec.output_name = spec_item.value("output_name", "");
+                
+                if (!spec.actuator_name.empty() && !spec.action_type.empty()) {
+                    config.specs.push_back(spec);
+                }
+            }
+        }
+        
+        if (act_config.contains("controllers")) {
+            for (const auto& controller_item : act_config["controllers"]) {
+                ControllerSpec controller = parseControllerSpec(controller_item);
+                if (controller.name.empty() || controller.type.empty()) {
+                    std::cerr << "[ConfigLoader] WARNING: Controller without name or type ignored" << std::endl;
+                    continue;
+                }
+                config.controllers.push_back(controller);
+            }
+        }
+        
+        std::cout << "[ConfigLoader] Action config loaded: " << config.specs.size() 
+                  << " action specs, " << config.substeps << " substeps per command";
+        if (!config.controllers.empty()) {
+            std::cout << ", " << config.controllers.size() << " controllers";
+        }
+        std::cout << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigLoader] ERROR parsing action JSON: " << e.what() << std::endl;
+    }
+    
+    return config;
+}
+
+ControllerSpec ConfigLoader::parseControllerSpec(const nlohmann::json& j) {
+    ControllerSpec controller;
+    controller.name = j.value("name", "");
+    controller.type = j.value("type", "");
+    controller.actuator = j.value("actuator", "");
+    controller.mode = j.value("mode", "position");
+    controller.kp = j.value("kp", 1.0f);
+    controller.ki = j.value("ki", 0.0f);
+    controller.kd = j.value("kd", 0.0f);
+    controller.integral_limit = j.value("integral_limit", std::numeric_limits<float>::max());
+    controller.output_limit = j.value("output_limit", std::numeric_limits<float>::max());
+    controller.rate_limit = j.value("rate_limit", 0.0f);
+    controller.thrust_model = j.value("thrust_model", "quadratic");
+    controller.max_setpoint = j.value("max_setpoint", 1.0f);
+    
+    if (j.contains("thrusters")) {
+        for (const auto& thruster_item : j["thrusters"]) {
+            ControllerThrusterSpec thruster;
+            thruster.name = thruster_item.value("name", "");
+            thruster.position = thruster_item.value("position", std::vector<float>());
+            thruster.direction = thruster_item.value("direction", std::vector<float>());
+            thruster.max_thrust = thruster_item.value("max_thrust", 1.0f);
+            controller.thrusters.push_back(thruster);
+        }
+    }
+    return controller;
+}
+
+RewardConfig ConfigLoader::loadRewardConfigFromFile(const std::string& filepath) {
+    try {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            std::cerr << "[ConfigLoader] ERROR: Cannot open reward config file: " << filepath << std::endl;
+            return RewardConfig();
+        }
+        
+        nlohmann::json j;
+        file >> j;
+        return parseRewardJsonConfig(j);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigLoader] ERROR: Failed to parse reward config file '" << filepath 
+                  << "': " << e.what() << std::endl;
+        return RewardConfig();
+    }
+}
+
+RewardConfig ConfigLoader::parseRewardJsonConfig(const nlohmann::json& j) {
+    RewardConfig config;
+    
+    // The section is optional, without it rewards stay on the client
+    if (!j.contains("reward_config")) {
+        return config;
+    }
+    
+    try {
+        const nlohmann::json& rew_config = j["reward_config"];
+        
+        int max_steps = rew_config.value("max_episode_steps", 0);
+        config.max_episode_steps = max_steps > 0 ? static_cast<unsigned int>(max_steps) : 0;
+        
+        if (rew_config.contains("terms")) {
+            for (const auto& term_item : rew_config["terms"]) {
+                RewardTermSpec term;
+                term.type = term_item.value("type", "");
+                term.entity = term_item.value("entity", "");
+                term.target = term_item.value("target", "");
+                term.target_position = term_item.value("target_position", std::vector<float>());
+                term.weight = term_item.value("weight", 1.0f);
+                term.radius = term_item.value("radius", 1.0f);
+                if (term_item.contains("target_yaw")) {
+                    term.has_target_yaw = true;
+                    term.target_yaw = term_item["target_yaw"].get<float>();
+                }
+                term.norm = term_item.value("norm", "l2");
+                term.box_min = term_item.value("min", std::vector<float>());
+                term.box_max = term_item.value("max", std::vector<float>());
+                term.inside = term_item.value("inside", true);
+                term.terminate = term_item.value("terminate", false);
+                
+                if (term.type.empty()) {
+                    std::cerr << "[ConfigLoader] WARNING: Reward term without type ignored" << std::endl;
+                    continue;
+                }
+                config.terms.push_back(term);
+            }
+        }
+        
+        std::cout << "[ConfigLoader] Reward config loaded: " << config.terms.size() << " terms";
+        if (config.max_episode_steps > 0) {
+            std::cout << ", truncation after " << config.max_episode_steps << " steps";
+        }
+        std::cout << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigLoader] ERROR parsing reward JSON: " << e.what() << std::endl;
+    }
+    
+    return config;
+}
+
+ResetConfig ConfigLoader::loadResetConfigFromFile(const std::string& filepath) {
+    try {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            std::cerr << "[ConfigLoader] ERROR: Cannot open reset config file: " << filepath << std::endl;
+            return ResetConfig();
+        }
+        
+        nlohmann::json j;
+        file >> j;
+        return parseResetJsonConfig(j);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigLoader] ERROR: Failed to parse reset config file '" << filepath 
+                  << "': " << e.what() << std::endl;
+        return ResetConfig();
+    }
+}
+
+ResetConfig ConfigLoader::parseResetJsonConfig(const nlohmann::json& j) {
+    ResetConfig config;
+    
+    // The section is optional, without it RESET only takes explicit poses
+    if (!j.contains("reset_config")) {
+        return config;
+    }
+    
+    try {
+        const nlohmann::json& reset_config = j["reset_config"];
+        
+        if (reset_config.contains("seed")) {
+            config.has_seed = true;
+            config.seed = reset_config["seed"].get<uint64_t>();
+        }
+        
+        if (reset_config.contains("entities")) {
+            for (const auto& entity_item : reset_config["entities"]) {
+                ResetEntitySpec entity;
+                entity.name = entity_item.value("name", "");
+                if (entity.name.empty()) {
+                    std::cerr << "[ConfigLoader] WARNING: Reset entity without name ignored" << std::endl;
+                    continue;
+                }
+                
+                // Either a list of alternative poses or a single pose
+                if (entity_item.contains("poses")) {
+                    for (const auto& pose_item : entity_item["poses"]) {
+                        entity.poses.push_back(parseResetPose(pose_item));
+                    }
+                } else {
+                    entity.poses.push_back(parseResetPose(entity_item));
+                }
+                config.entities.push_back(entity);
+            }
+        }
+        
+        std::cout << "[ConfigLoader] Reset config loaded: " << config.entities.size() << " entities";
+        if (config.has_seed) {
+            std::cout << ", seed " << config.seed;
+        }
+        std::cout << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigLoader] ERROR parsing reset JSON: " << e.what() << std::endl;
+        config.entities.clear();
+    }
+    
+    return config;
+}
+
+ResetPoseSpec ConfigLoader::parseResetPose(const nlohmann::json& j) {
+    ResetPoseSpec pose;
+    if (j.contains("position")) {
+        for (const auto& value : j["position"]) {
+            pose.position.push_back(parseResetDistribution(value));
+        }
+    }
+    if (j.contains("rotation")) {
+        for (const auto& value : j["rotation"]) {
+            pose.rotation.push_back(parseResetDistribution(value));
+        }
+    }
+    if (pose.position.size() != 3 || (!pose.rotation.empty() && pose.rotation.size() != 3)) {
+        std::cerr << "[ConfigLoader] WARNING: Reset pose needs 3 position values and 0 or 3 rotation values" << std::endl;
+    }
+    return pose;
+}
+
+ResetDistribution ConfigLoader::parseResetDistribution(const nlohmann::json& j) {
+    ResetDistribution dist;
+    
+    // A plain number is a fixed value
+    if (j.is_number()) {
+        dist.a = j.get<float>();
+        return dist;
+    }
+    
+    if (j.contains("uniform")) {
+        dist.type = ResetDistribution::Type::UNIFORM;
+        dist.a = j["uniform"].at(0).get<float>();
+        dist.b = j["uniform"].at(1).get<float>();
+    } else if (j.contains("normal")) {
+        dist.type = ResetDistribution::Type::NORMAL;
+        dist.a = j["normal"].at(0).get<float>();
+        dist.b = j["normal"].at(1).get<float>();
+    } else if (j.contains("choice")) {
+        dist.type = ResetDistribution::Type::CHOICE;
+        dist.choices = j["choice"].get<std::vector<float>>();
+        if (dist.choices.empty()) {
+            dist.type = ResetDistribution::Type::FIXED;
+        }
+    } else {
+        std::cerr << "[ConfigLoader] WARNING: Unknown reset distribution " << j.dump() << ", using 0" << std::endl;
+    }
+    dist.min = j.value("min", dist.min);
+    dist.max = j.value("max", dist.max);
+    return dist;
+}
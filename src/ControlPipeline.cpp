@@ -0,0 +1,305 @@
+#include "ControlPipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// In-place inverse of a small square matrix (Gauss-Jordan, partial pivoting). False if singular
+bool invert(std::vector<double>& m, size_t n) {
+    std::vector<double> inv(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) inv[i * n + i] = 1.0;
+
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; ++row) {
+            if (std::fabs(m[row * n + col]) > std::fabs(m[pivot * n + col])) pivot = row;
+        }
+        if (std::fabs(m[pivot * n + col]) < 1e-12) return false;
+        for (size_t k = 0; k < n; ++k) {
+            std::swap(m[col * n + k], m[pivot * n + k]);
+            std::swap(inv[col * n + k], inv[pivot * n + k]);
+        }
+        double scale = 1.0 / m[col * n + col];
+        for (size_t k = 0; k < n; ++k) {
+            m[col * n + k] *= scale;
+            inv[col * n + k] *= scale;
+        }
+        for (size_t row = 0; row < n; ++row) {
+            if (row == col) continue;
+            double factor = m[row * n + col];
+            if (factor == 0.0) continue;
+            for (size_t k = 0; k < n; ++k) {
+                m[row * n + k] -= factor * m[col * n + k];
+                inv[row * n + k] -= factor * inv[col * n + k];
+            }
+        }
+    }
+    m.swap(inv);
+    return true;
+}
+
+}  // namespace
+
+const std::unordered_map<std::string, ControlPipeline::ControllerType>& ControlPipeline::controllerTypes() {
+    static const std::unordered_map<std::string, ControllerType> types = {
+        {"servo_pid", ControllerType::SERVO_PID},
+        {"wrench", ControllerType::WRENCH},
+        {"rate_limit", ControllerType::RATE_LIMIT}
+    };
+    return types;
+}
+
+const std::vector<std::string>& ControlPipeline::wrenchChannels() {
+    static const std::vector<std::string> channels = {"FX", "FY", "FZ", "TX", "TY", "TZ"};
+    return channels;
+}
+
+void ControlPipeline::compile(sf::SimulationManager* sim) {
+    controllers_.clear();
+    size_t unresolved = 0;
+
+    for (const ControllerSpec& spec : specs_) {
+        Controller controller;
+        controller.spec = &spec;
+        controller.velocity_mode = spec.mode == "velocity";
+
+        auto type = controllerTypes().find(spec.type);
+        if (type == controllerTypes().end()) {
+            std::cerr << "[ControlPipeline] WARNING: Unknown controller type '" << spec.type << "'" << std::endl;
+            ++unresolved;
+            continue;
+        }
+        controller.type = type->second;
+
+        bool resolved = true;
+        if (controller.type == ControllerType::WRENCH) {
+            resolved = compileWrench(sim, controller);
+        } else {
+            sf::Actuator* actuator = sim->getActuator(spec.actuator);
+            if (actuator && actuator->getType() == sf::ActuatorType::SERVO) {
+                controller.servo = dynamic_cast<sf::Servo*>(actuator);
+            } else if (actuator && actuator->getType() == sf::ActuatorType::THRUSTER) {
+                controller.thruster = dynamic_cast<sf::Thruster*>(actuator);
+            }
+            // PID needs a servo measurement, the rate limiter drives either
+            resolved = controller.servo || (controller.type == ControllerType::RATE_LIMIT && controller.thruster);
+            if (!resolved) {
+                std::cerr << "[ControlPipeline] WARNING: No " << (controller.type == ControllerType::SERVO_PID
+                          ? "servo" : "servo or thruster") << " '" << spec.actuator << "' for controller "
+                          << spec.name << std::endl;
+            }
+        }
+        if (!resolved) {
+            ++unresolved;
+            continue;
+        }
+
+        size_t num_inputs = controller.type == ControllerType::WRENCH ? wrenchChannels().size() : 1;
+        controller.inputs.assign(num_inputs, 0.0f);
+        controller.setpoints.assign(num_inputs, 0.0f);
+        controllers_.push_back(controller);
+    }
+
+    std::cout << "[ControlPipeline] " << controllers_.size() << " controllers";
+    if (unresolved > 0) {
+        std::cout << ", " << unresolved << " ignored";
+    }
+    std::cout << std::endl;
+}
+
+bool ControlPipeline::compileWrench(sf::SimulationManager* sim, Controller& controller) {
+    const ControllerSpec& spec = *controller.spec;
+    size_t n = spec.thrusters.size();
+    if (n == 0) {
+        std::cerr << "[ControlPipeline] WARNING: Wrench controller " << spec.name << " has no thrusters" << std::endl;
+        return false;
+    }
+
+    // B (6 x n): column j is the wrench of thruster j at max_thrust = 1 [N]
+    std::vector<double> b(6 * n, 0.0);
+    for (size_t j = 0; j < n; ++j) {
+        const ControllerThrusterSpec& thruster_spec = spec.thrusters[j];
+        sf::Actuator* actuator = sim->getActuator(thruster_spec.name);
+        sf::Thruster* thruster = actuator && actuator->getType() == sf::ActuatorType::THRUSTER
+            ? dynamic_cast<sf::Thruster*>(actuator) : nullptr;
+        if (!thruster || thruster_spec.position.size() != 3 || thruster_spec.direction.size() != 3) {
+            std::cerr << "[ControlPipeline] WARNING: Thruster '" << thruster_spec.name << "' of controller "
+                      << spec.name << " not found or without position/direction" << std::endl;
+            return false;
+        }
+        controller.thrusters.push_back(thruster);
+
+        double d[3], r[3];
+        double norm = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            d[k] = thruster_spec.direction[k];
+            r[k] = thruster_spec.position[k];
+            norm += d[k] * d[k];
+        }
+        norm = std::sqrt(norm);
+        if (norm < 1e-9) {
+            std::cerr << "[ControlPipeline] WARNING: Thruster '" << thruster_spec.name << "' has no direction" << std::endl;
+            return false;
+        }
+        for (double& v : d) v /= norm;
+        b[0 * n + j] = d[0];
+        b[1 * n + j] = d[1];
+        b[2 * n + j] = d[2];
+        b[3 * n + j] = r[1] * d[2] - r[2] * d[1];
+        b[4 * n + j] = r[2] * d[0] - r[0] * d[2];
+        b[5 * n + j] = r[0] * d[1] - r[1] * d[0];
+    }
+
+    std::vector<double> t;
+    if (!solveAllocation(b, n, t)) {
+        std::cerr << "[ControlPipeline] WARNING: Thrusters of controller " << spec.name
+                  << (n <= 6 ? " are linearly dependent" : " do not span all 6 DOF") << std::endl;
+        return false;
+    }
+    controller.allocation.assign(t.begin(), t.end());
+    return true;
+}
+
+bool ControlPipeline::solveAllocation(const std::vector<double>& b, size_t n, std::vector<double>& t) {
+    // Minimum wrench error with n < 6 thrusters ((B^T B)^-1 B^T),
+    // minimum thrust norm with n > 6 (B^T (B B^T)^-1)
+    t.assign(n * 6, 0.0);
+    if (n <= 6) {
+        std::vector<double> btb(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i)
+            for (size_t k = 0; k < n; ++k)
+                for (size_t r = 0; r < 6; ++r) btb[i * n + k] += b[r * n + i] * b[r * n + k];
+        if (!invert(btb, n)) return false;
+        for (size_t i = 0; i < n; ++i)
+            for (size_t c = 0; c < 6; ++c)
+                for (size_t k = 0; k < n; ++k) t[i * 6 + c] += btb[i * n + k] * b[c * n + k];
+    } else {
+        std::vector<double> bbt(36, 0.0);
+        for (size_t r = 0; r < 6; ++r)
+            for (size_t c = 0; c < 6; ++c)
+                for (size_t k = 0; k < n; ++k) bbt[r * 6 + c] += b[r * n + k] * b[c * n + k];
+        if (!invert(bbt, 6)) return false;
+        for (size_t i = 0; i < n; ++i)
+            for (size_t c = 0; c < 6; ++c)
+                for (size_t k = 0; k < 6; ++k) t[i * 6 + c] += b[k * n + i] * bbt[k * 6 + c];
+    }
+    return true;
+}
+
+float* ControlPipeline::findInput(const std::string& name, const std::string& channel) {
+    for (Controller& controller : controllers_) {
+        if (controller.spec->name != name) continue;
+        if (controller.type == ControllerType::WRENCH) {
+            const std::vector<std::string>& channels = wrenchChannels();
+            auto it = std::find(channels.begin(), channels.end(), channel);
+            return it == channels.end() ? nullptr : &controller.inputs[it - channels.begin()];
+        }
+        return channel == "SETPOINT" ? &controller.inputs[0] : nullptr;
+    }
+    return nullptr;
+}
+
+void ControlPipeline::update(float dt) {
+    if (dt <= 0.0f) return;
+
+    for (Controller& controller : controllers_) {
+        // Slew the setpoints towards the latest agent inputs
+        float max_change = controller.spec->rate_limit * dt;
+        for (size_t i = 0; i < controller.inputs.size(); ++i) {
+            float change = controller.inputs[i] - controller.setpoints[i];
+            if (controller.spec->rate_limit > 0.0f) {
+                change = std::max(-max_change, std::min(max_change, change));
+            }
+            controller.setpoints[i] += change;
+        }
+
+        switch (controller.type) {
+        case ControllerType::SERVO_PID:
+            updateServoPid(controller, dt);
+            break;
+        case ControllerType::WRENCH:
+            updateWrench(controller);
+            break;
+        case ControllerType::RATE_LIMIT:
+            updateRateLimit(controller);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void ControlPipeline::updateServoPid(Controller& controller, float dt) {
+    const ControllerSpec& spec = *controller.spec;
+    float setpoint = controller.setpoints[0];
+    float measurement = static_cast<float>(controller.velocity_mode ? controller.servo->getVelocity()
+                                                                    : controller.servo->getPosition());
+    float error = setpoint - measurement;
+    controller.integral = std::max(-spec.integral_limit, std::min(spec.integral_limit, controller.integral + error * dt));
+    // Derivative on the measurement, setpoint jumps do not kick the output
+    float derivative = controller.has_measurement ? -(measurement - controller.last_measurement) / dt : 0.0f;
+    controller.last_measurement = measurement;
+    controller.has_measurement = true;
+
+    float command = spec.kp * error + spec.ki * controller.integral + spec.kd * derivative;
+    if (controller.velocity_mode) {
+        command += setpoint;
+    }
+    command = std::max(-spec.output_limit, std::min(spec.output_limit, command));
+    applyServo(controller.servo, true, command);
+}
+
+void ControlPipeline::updateWrench(Controller& controller) {
+    const ControllerSpec& spec = *controller.spec;
+    const float* wrench = controller.setpoints.data();
+    for (size_t j = 0; j < controller.thrusters.size(); ++j) {
+        const float* row = &controller.allocation[j * 6];
+        float thrust = row[0] * wrench[0] + row[1] * wrench[1] + row[2] * wrench[2]
+                     + row[3] * wrench[3] + row[4] * wrench[4] + row[5] * wrench[5];
+        controller.thrusters[j]->setSetpoint(thrustToSetpoint(spec, thrust, spec.thrusters[j].max_thrust));
+    }
+}
+
+void ControlPipeline::updateRateLimit(Controller& controller) {
+    if (controller.servo) {
+        applyServo(controller.servo, controller.velocity_mode, controller.setpoints[0]);
+    } else {
+        controller.thruster->setSetpoint(controller.setpoints[0]);
+    }
+}
+
+void ControlPipeline::applyServo(sf::Servo* servo, bool velocity_mode, float value) {
+    if (velocity_mode) {
+        servo->setControlMode(sf::ServoControlMode::VELOCITY);
+        servo->setDesiredVelocity(value);
+    } else {
+        servo->setControlMode(sf::ServoControlMode::POSITION);
+        servo->setDesiredPosition(value);
+    }
+}
+
+float ControlPipeline::thrustToSetpoint(const ControllerSpec& spec, float thrust, float max_thrust) {
+    if (max_thrust <= 0.0f) return 0.0f;
+    float ratio = thrust / max_thrust;
+    float setpoint = spec.thrust_model == "linear" ? ratio : std::copysign(std::sqrt(std::fabs(ratio)), ratio);
+    setpoint *= spec.max_setpoint;
+    return std::max(-spec.max_setpoint, std::min(spec.max_setpoint, setpoint));
+}
+
+void ControlPipeline::reset() {
+    for (Controller& controller : controllers_) {
+        std::fill(controller.inputs.begin(), controller.inputs.end(), 0.0f);
+        std::fill(controller.setpoints.begin(), controller.setpoints.end(), 0.0f);
+        controller.integral = 0.0f;
+        controller.has_measurement = false;
+    }
+}
+
+std::vector<std::string> ControlPipeline::getControllerNames() const {
+    std::vector<std::string> names;
+    for (const Controller& controller : controllers_) {
+        names.push_back(controller.spec->name);
+    }
+    return names;
+}
@@ -0,0 +1,91 @@
+#include "EpisodeLog.h"
+#include <iostream>
+
+EpisodeLogWriter::~EpisodeLogWriter() {
+    close();
+}
+
+bool EpisodeLogWriter::open(const std::string& path, uint32_t observation_size, uint32_t action_size, double frequency) {
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "[EpisodeLog] ERROR: Cannot create log file: " << path << std::endl;
+        return false;
+    }
+    buffer_.resize(1 << 20);
+    std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+    sequence_ = 0;
+
+    EpisodeLogHeader header{};
+    header.magic = EPISODE_LOG_MAGIC;
+    header.version = EPISODE_LOG_VERSION;
+    header.observation_size = observation_size;
+    header.action_size = action_size;
+    header.frequency = frequency;
+    std::fwrite(&header, sizeof(header), 1, file_);
+    std::cout << "[EpisodeLog] Recording to " << path << std::endl;
+    return true;
+}
+
+void EpisodeLogWriter::close() {
+    if (!file_) return;
+    std::fclose(file_);
+    file_ = nullptr;
+    std::cout << "[EpisodeLog] Recorded " << sequence_ << " inputs" << std::endl;
+}
+
+void EpisodeLogWriter::write(LogRecordType type, unsigned int substeps, double sim_time, const void* data, size_t size) {
+    LogRecordHeader record{};
+    record.type = static_cast<uint16_t>(type);
+    record.substeps = static_cast<uint16_t>(substeps);
+    record.sequence = sequence_;
+    record.size = static_cast<uint32_t>(size);
+    record.sim_time = sim_time;
+    std::fwrite(&record, sizeof(record), 1, file_);
+    if (size > 0) {
+        std::fwrite(data, 1, size, file_);
+    }
+}
+
+void EpisodeLogWriter::writeInput(LogRecordType type, unsigned int substeps, double sim_time, const void* data, size_t size) {
+    if (!file_) return;
+    ++sequence_;
+    write(type, substeps, sim_time, data, size);
+}
+
+void EpisodeLogWriter::writeObservation(double sim_time, const float* values, size_t count) {
+    if (!file_) return;
+    write(LogRecordType::OBSERVATION, 0, sim_time, values, count * sizeof(float));
+}
+
+EpisodeLogReader::~EpisodeLogReader() {
+    if (file_) std::fclose(file_);
+}
+
+bool EpisodeLogReader::open(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "[EpisodeLog] ERROR: Cannot open log file: " << path << std::endl;
+        return false;
+    }
+    if (std::fread(&header_, sizeof(header_), 1, file_) != 1 || header_.magic != EPISODE_LOG_MAGIC 
+        || header_.version != EPISODE_LOG_VERSION) {
+        std::cerr << "[EpisodeLog] ERROR: Not an episode log (or unsupported version): " << path << std::endl;
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool EpisodeLogReader::next(LogRecordHeader& record, std::vector<char>& payload) {
+    if (!file_ || std::fread(&record, sizeof(record), 1, file_) != 1) {
+        return false;
+    }
+    payload.resize(record.size);
+    if (record.size > 0 && std::fread(payload.data(), 1, record.size, file_) != record.size) {
+        std::cerr << "[EpisodeLog] WARNING: Truncated record at the end of the log" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#include "HistoryRing.h"
+#include <algorithm>
+
+void HistoryRing::resize(size_t length, size_t frame_size) {
+    length_ = std::max<size_t>(1, length);
+    frame_size_ = frame_size;
+    ring_.assign(length_ * frame_size_, 0.0f);
+    block_.assign(length_ * frame_size_, 0.0f);
+    head_ = 0;
+    filled_ = false;
+}
+
+const std::vector<float>& HistoryRing::push(const float* observation, size_t num_observations,
+                                            const float* actions, size_t num_actions, bool reset) {
+    if (reset || !filled_) {
+        head_ = 0;
+        filled_ = false;
+    }
+
+    size_t frame = frame_size_;
+    num_observations = std::min(num_observations, frame);
+    num_actions = std::min(num_actions, frame - num_observations);
+    float* slot = ring_.data() + head_ * frame;
+    std::copy(observation, observation + num_observations, slot);
+    std::copy(actions, actions + num_actions, slot + num_observations);
+    std::fill(slot + num_observations + num_actions, slot + frame, 0.0f);
+    if (!filled_) {
+        // First frame of an episode stands in for the frames before it
+        for (size_t k = 1; k < length_; ++k) {
+            std::copy(slot, slot + frame, ring_.data() + k * frame);
+        }
+        filled_ = true;
+    }
+    head_ = (head_ + 1) % length_;
+
+    // Oldest frame is the next one to be overwritten: [head, end) then [0, head)
+    size_t split = head_ * frame;
+    std::copy(ring_.begin() + split, ring_.end(), block_.begin());
+    std::copy(ring_.begin(), ring_.begin() + split, block_.end() - split);
+    return block_;
+}
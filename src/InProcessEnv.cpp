@@ -0,0 +1,80 @@
+#include "InProcessEnv.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+std::atomic<bool> InProcessEnv::instance_alive_{false};
+
+InProcessEnv::InProcessEnv(const std::string& scene_path, const std::string& resources_path,
+                           const std::string& observation_conf_path, const std::string& action_conf_path,
+                           double frequency) {
+    if (instance_alive_.exchange(true)) {
+        std::cerr << "[InProcessEnv] ERROR: Only one in-process environment per process is supported" << std::endl;
+        return;
+    }
+
+    // No address: the environment is only driven through this class
+    StonefishRL* sim = new StonefishRL(scene_path, observation_conf_path, action_conf_path, frequency, "");
+    app_ = std::make_unique<sf::ConsoleSimulationApp>("STONEFISH RL", resources_path, sim);
+    sim->RestartScenario();
+    sim->StartSimulation();
+    sim_ = sim;
+    std::cout << "[InProcessEnv] Ready: " << getObservationSize() << " observations, " 
+              << getActionSize() << " actions" << std::endl;
+}
+
+InProcessEnv::~InProcessEnv() {
+    close();
+}
+
+void InProcessEnv::close() {
+    if (!sim_) return;
+    sim_->StopSimulation();
+    app_.reset();
+    sim_ = nullptr;
+    instance_alive_ = false;
+}
+
+size_t InProcessEnv::reset(const std::string& payload, float* out, size_t capacity) {
+    size_t count = 0;
+    sim_->Reset(payload, [&]() { count = observe(OBS_FLAG_RESET, out, capacity); });
+    return count;
+}
+
+size_t InProcessEnv::step(const float* actions, size_t count, unsigned int substeps, float* out, size_t capacity) {
+    StepProfiler& profiler = sim_->getProfiler();
+    auto t_apply = StepProfiler::now();
+    sim_->ApplyActionVector(actions, count);
+    profiler.record(StepPhase::APPLY, t_apply);
+
+    unsigned int steps = substeps > 0 ? substeps : sim_->getDefaultSubsteps();
+    auto t_step = StepProfiler::now();
+    sim_->StepPhysics(steps);
+    profiler.record(StepPhase::STEP, t_step);
+    profiler.countStep(steps);
+    return observe(0, out, capacity);
+}
+
+size_t InProcessEnv::restoreSnapshot(unsigned int slot, float* out, size_t capacity) {
+    if (!sim_->RestoreSnapshot(slot)) {
+        return 0;
+    }
+    return observe(OBS_FLAG_RESET, out, capacity);
+}
+
+std::string InProcessEnv::stats(bool reset) {
+    std::string report = sim_->getProfiler().report();
+    if (reset) {
+        sim_->getProfiler().reset();
+    }
+    return report;
+}
+
+size_t InProcessEnv::observe(uint16_t flags, float* out, size_t capacity) {
+    auto t_observe = StepProfiler::now();
+    const std::vector<float>& observations = sim_->GetObservations(flags);
+    size_t count = std::min(capacity, observations.size());
+    std::memcpy(out, observations.data(), count * sizeof(float));
+    sim_->getProfiler().record(StepPhase::OBSERVE, t_observe);
+    return count;
+}
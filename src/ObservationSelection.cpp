@@ -0,0 +1,25 @@
+#include "ObservationSelection.h"
+#include <algorithm>
+
+void ObservationSelection::addRange(std::vector<Range>& ranges, size_t offset, size_t count) {
+    if (!ranges.empty() && ranges.back().offset + ranges.back().count == offset) {
+        ranges.back().count += count;
+    } else {
+        ranges.push_back({offset, count});
+    }
+}
+
+float* ObservationSelection::begin(size_t count) {
+    values_.resize(count);
+    return values_.data();
+}
+
+const std::vector<float>& ObservationSelection::gather(const std::vector<Range>& ranges, const float* full) {
+    size_t count = 0;
+    for (const Range& range : ranges) count += range.count;
+    float* out = begin(count);
+    for (const Range& range : ranges) {
+        out = std::copy(full + range.offset, full + range.offset + range.count, out);
+    }
+    return values_;
+}
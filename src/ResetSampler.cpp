@@ -0,0 +1,89 @@
+#include "ResetSampler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+}  // namespace
+
+bool ResetSampler::parseSeed(const std::string& text, uint64_t& seed) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    errno = 0;
+    unsigned long long value = std::strtoull(text.c_str(), nullptr, 10);
+    if (errno == ERANGE) return false;
+    seed = value;
+    return true;
+}
+
+uint64_t ResetSampler::environmentSeed(uint64_t seed, uint64_t index) {
+    return splitmix64(splitmix64(seed) + index);
+}
+
+void ResetSampler::setConfig(const ResetConfig& config) {
+    config_ = config;
+    seed_stream_.seed(config_.has_seed ? config_.seed : std::random_device{}());
+}
+
+std::vector<RobotResetInfo> ResetSampler::sample(uint64_t seed) {
+    rng_.seed(seed);
+    std::vector<RobotResetInfo> result;
+    last_sample_ = nlohmann::json::object();
+    last_sample_["seed"] = seed;
+    nlohmann::json entities = nlohmann::json::array();
+
+    for (const ResetEntitySpec& entity : config_.entities) {
+        if (entity.poses.empty()) continue;
+        size_t choice = 0;
+        if (entity.poses.size() > 1) {
+            choice = std::uniform_int_distribution<size_t>(0, entity.poses.size() - 1)(rng_);
+        }
+        const ResetPoseSpec& pose = entity.poses[choice];
+
+        RobotResetInfo info;
+        info.name = entity.name;
+        for (const ResetDistribution& dist : pose.position) {
+            info.position.push_back(draw(dist));
+        }
+        for (const ResetDistribution& dist : pose.rotation) {
+            info.rotation.push_back(draw(dist));
+        }
+        result.push_back(info);
+
+        nlohmann::json sampled;
+        sampled["name"] = info.name;
+        sampled["position"] = info.position;
+        sampled["rotation"] = info.rotation;
+        if (entity.poses.size() > 1) {
+            sampled["pose"] = choice;
+        }
+        entities.push_back(sampled);
+    }
+    last_sample_["entities"] = entities;
+    return result;
+}
+
+float ResetSampler::draw(const ResetDistribution& dist) {
+    float value = dist.a;
+    switch (dist.type) {
+    case ResetDistribution::Type::UNIFORM:
+        value = std::uniform_real_distribution<float>(std::min(dist.a, dist.b), std::max(dist.a, dist.b))(rng_);
+        break;
+    case ResetDistribution::Type::NORMAL:
+        value = dist.b > 0.0f ? std::normal_distribution<float>(dist.a, dist.b)(rng_) : dist.a;
+        break;
+    case ResetDistribution::Type::CHOICE:
+        value = dist.choices[std::uniform_int_distribution<size_t>(0, dist.choices.size() - 1)(rng_)];
+        break;
+    case ResetDistribution::Type::FIXED:
+        break;
+    }
+    return std::min(std::max(value, dist.min), dist.max);
+}
@@ -0,0 +1,196 @@
+#include "RewardEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+float wrapAngle(float angle) {
+    return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+}  // namespace
+
+const std::unordered_map<std::string, RewardEngine::TermType>& RewardEngine::termTypes() {
+    static const std::unordered_map<std::string, TermType> types = {
+        {"distance", TermType::DISTANCE},
+        {"proximity", TermType::PROXIMITY},
+        {"heading_error", TermType::HEADING_ERROR},
+        {"collision", TermType::COLLISION},
+        {"action_magnitude", TermType::ACTION_MAGNITUDE},
+        {"region", TermType::REGION}
+    };
+    return types;
+}
+
+void RewardEngine::compile(sf::SimulationManager* sim, StateManager& state) {
+    terms_.clear();
+    state_ = &state;
+    outcome_ = StepOutcome();
+    episode_steps_ = 0;
+    size_t unresolved = 0;
+
+    for (const RewardTermSpec& spec : config_.terms) {
+        CompiledTerm term;
+        term.spec = &spec;
+
+        auto type = termTypes().find(spec.type);
+        if (type == termTypes().end()) {
+            std::cerr << "[RewardEngine] WARNING: Unknown reward term type '" << spec.type << "'" << std::endl;
+            ++unresolved;
+            continue;
+        }
+        term.type = type->second;
+
+        // Every term but the action cost is about one robot
+        if (term.type != TermType::ACTION_MAGNITUDE) {
+            term.entity = findRobot(sim, spec.entity);
+            if (!term.entity) {
+                std::cerr << "[RewardEngine] WARNING: Robot '" << spec.entity << "' not found for "
+                          << spec.type << " term" << std::endl;
+                ++unresolved;
+                continue;
+            }
+        }
+
+        if (!spec.target.empty()) {
+            term.target = findRobot(sim, spec.target);
+            if (!term.target) {
+                std::cerr << "[RewardEngine] WARNING: Target robot '" << spec.target << "' not found for "
+                          << spec.type << " term" << std::endl;
+                ++unresolved;
+                continue;
+            }
+        }
+        for (size_t i = 0; i < 3 && i < spec.target_position.size(); ++i) {
+            term.target_position[i] = spec.target_position[i];
+        }
+
+        if (term.type == TermType::REGION && !spec.box_min.empty()
+            && (spec.box_min.size() != 3 || spec.box_max.size() != 3)) {
+            std::cerr << "[RewardEngine] WARNING: Region box needs 3 values in min and max" << std::endl;
+            ++unresolved;
+            continue;
+        }
+
+        if (term.type == TermType::COLLISION) {
+            term.collision_slot = state.watchCollisions(sim, term.entity);
+        }
+        terms_.push_back(term);
+    }
+
+    std::cout << "[RewardEngine] " << terms_.size() << " reward terms";
+    if (config_.max_episode_steps > 0) {
+        std::cout << ", truncation after " << config_.max_episode_steps << " steps";
+    }
+    if (unresolved > 0) {
+        std::cout << ", " << unresolved << " ignored";
+    }
+    std::cout << std::endl;
+}
+
+const StepOutcome& RewardEngine::evaluate(const std::vector<float>& actions, bool reset) {
+    outcome_ = StepOutcome();
+    if (reset) {
+        episode_steps_ = 0;
+        return outcome_;
+    }
+    ++episode_steps_;
+
+    double reward = 0.0;
+    for (const CompiledTerm& term : terms_) {
+        float value = evaluateTerm(term, actions);
+        reward += static_cast<double>(term.spec->weight) * value;
+        if (value > 0.0f && term.spec->terminate
+            && (term.type == TermType::COLLISION || term.type == TermType::REGION)) {
+            outcome_.terminated = true;
+        }
+    }
+    outcome_.reward = static_cast<float>(reward);
+    outcome_.truncated = config_.max_episode_steps > 0 && episode_steps_ >= config_.max_episode_steps;
+    return outcome_;
+}
+
+float RewardEngine::evaluateTerm(const CompiledTerm& term, const std::vector<float>& actions) const {
+    switch (term.type) {
+    case TermType::COLLISION:
+        return state_->getCollisionFlag(term.collision_slot);
+    case TermType::ACTION_MAGNITUDE: {
+        float sum = 0.0f;
+        bool l1 = term.spec->norm == "l1";
+        for (float a : actions) {
+            sum += l1 ? std::fabs(a) : a * a;
+        }
+        return sum;
+    }
+    default:
+        break;
+    }
+
+    float position[3], target[3], delta[3];
+    robotPosition(term.entity, position);
+    targetPosition(term, target);
+    for (int i = 0; i < 3; ++i) {
+        delta[i] = position[i] - target[i];
+    }
+    float distance = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+
+    switch (term.type) {
+    case TermType::DISTANCE:
+        return distance;
+    case TermType::PROXIMITY:
+        return term.spec->radius > 0.0f ? std::max(0.0f, 1.0f - distance / term.spec->radius) : 0.0f;
+    case TermType::HEADING_ERROR: {
+        float yaw = robotYaw(term.entity);
+        float desired = term.spec->has_target_yaw ? term.spec->target_yaw : std::atan2(-delta[1], -delta[0]);
+        return std::fabs(wrapAngle(desired - yaw));
+    }
+    case TermType::REGION: {
+        bool inside;
+        if (!term.spec->box_min.empty()) {
+            inside = true;
+            for (int i = 0; i < 3; ++i) {
+                inside = inside && delta[i] >= term.spec->box_min[i] && delta[i] <= term.spec->box_max[i];
+            }
+        } else {
+            inside = distance <= term.spec->radius;
+        }
+        return inside == term.spec->inside ? 1.0f : 0.0f;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+void RewardEngine::targetPosition(const CompiledTerm& term, float out[3]) const {
+    if (term.target) {
+        robotPosition(term.target, out);
+        return;
+    }
+    out[0] = term.target_position[0];
+    out[1] = term.target_position[1];
+    out[2] = term.target_position[2];
+}
+
+void RewardEngine::robotPosition(sf::Robot* robot, float out[3]) {
+    sf::Transform tf = robot->getTransform();
+    const sf::Vector3& origin = tf.getOrigin();
+    out[0] = static_cast<float>(origin.x());
+    out[1] = static_cast<float>(origin.y());
+    out[2] = static_cast<float>(origin.z());
+}
+
+float RewardEngine::robotYaw(sf::Robot* robot) {
+    sf::Scalar yaw, pitch, roll;
+    robot->getTransform().getRotation().getEulerZYX(yaw, pitch, roll);
+    return static_cast<float>(yaw);
+}
+
+sf::Robot* RewardEngine::findRobot(sf::SimulationManager* sim, const std::string& name) {
+    unsigned int id = 0;
+    sf::Robot* robot;
+    while ((robot = sim->getRobot(id++)) != nullptr) {
+        if (robot->getName() == name) return robot;
+    }
+    return nullptr;
+}
@@ -0,0 +1,235 @@
+#include "SharedMemoryTransport.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+
+#ifdef __linux__
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+#endif
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    close();
+}
+
+bool SharedMemoryTransport::open(const std::string& name, size_t obs_capacity, size_t action_capacity) {
+    close();
+
+    name_ = name;
+    std::string shm_name = "/" + name;
+    size_ = SHM_HEADER_SIZE + (obs_capacity + action_capacity) * sizeof(float);
+
+    shm_unlink(shm_name.c_str()); // left over from a crashed server
+    fd_ = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd_ < 0) {
+        std::cerr << "[SharedMemory] ERROR: shm_open failed for " << shm_name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        std::cerr << "[SharedMemory] ERROR: ftruncate failed: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    void* base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "[SharedMemory] ERROR: mmap failed: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    std::memset(base, 0, size_);
+    header_ = new (base) SharedMemoryHeader();
+    header_->magic = SHM_MAGIC;
+    header_->version = SHM_VERSION;
+    header_->obs_capacity = static_cast<uint32_t>(obs_capacity);
+    header_->action_capacity = static_cast<uint32_t>(action_capacity);
+    header_->request_seq.store(0, std::memory_order_relaxed);
+    header_->wake_seq.store(0, std::memory_order_relaxed);
+    header_->control_seq.store(0, std::memory_order_relaxed);
+    header_->reply_seq.store(0, std::memory_order_release);
+
+    observations_ = reinterpret_cast<float*>(static_cast<char*>(base) + SHM_HEADER_SIZE);
+    actions_ = observations_ + obs_capacity;
+    obs_capacity_ = obs_capacity;
+    action_capacity_ = action_capacity;
+    served_seq_ = 0;
+    served_control_ = 0;
+
+    std::cout << "[SharedMemory] Segment " << shm_name << " ready (" << obs_capacity << " observations, "
+              << action_capacity << " actions, " << size_ << " bytes)" << std::endl;
+    return true;
+}
+
+void SharedMemoryTransport::close() {
+    if (header_) {
+        // Tell a waiting client that no reply will come
+        header_->flags |= SHM_FLAG_CLOSED;
+        header_->reply_seq.fetch_add(1, std::memory_order_release);
+        futexWake(&header_->reply_seq);
+        munmap(header_, size_);
+        header_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(("/" + name_).c_str());
+    }
+    observations_ = nullptr;
+    actions_ = nullptr;
+}
+
+ShmWake SharedMemoryTransport::waitRequest(int timeout_ms) {
+    if (!header_) return ShmWake::NONE;
+
+    // The wake word is read first: a ring after this load changes it and the futex returns at once
+    uint32_t wake = header_->wake_seq.load(std::memory_order_acquire);
+    ShmWake pending = pendingWake();
+    if (pending != ShmWake::NONE) return pending;
+
+    futexWait(&header_->wake_seq, wake, timeout_ms);
+    return pendingWake();
+}
+
+ShmWake SharedMemoryTransport::pendingWake() {
+    if (header_->request_seq.load(std::memory_order_acquire) != served_seq_) {
+        return ShmWake::STEP;
+    }
+    uint32_t control = header_->control_seq.load(std::memory_order_acquire);
+    if (control != served_control_) {
+        served_control_ = control;
+        return ShmWake::CONTROL;
+    }
+    return ShmWake::NONE;
+}
+
+void SharedMemoryTransport::publishObservations(const float* values, size_t count, double sim_time, uint32_t sequence,
+                                                const StepOutcome* outcome) {
+    if (!header_) return;
+
+    count = std::min(count, obs_capacity_);
+    std::memcpy(observations_, values, count * sizeof(float));
+    header_->obs_count = static_cast<uint32_t>(count);
+    header_->sim_time = sim_time;
+    header_->obs_sequence = sequence;
+    header_->reward = outcome ? outcome->reward : 0.0f;
+    header_->outcome = outcome ? (SHM_OUTCOME_VALID | (outcome->terminated ? SHM_OUTCOME_TERMINATED : 0)
+                                  | (outcome->truncated ? SHM_OUTCOME_TRUNCATED : 0)) : 0;
+
+    served_seq_ = header_->request_seq.load(std::memory_order_acquire);
+    header_->reply_seq.store(served_seq_, std::memory_order_release);
+    futexWake(&header_->reply_seq);
+}
+
+void SharedMemoryTransport::futexWait(std::atomic<uint32_t>* addr, uint32_t expected, int timeout_ms) {
+#ifdef __linux__
+    // Shared (not private) futex, the word lives in a segment mapped by two processes
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+    if (addr->load(std::memory_order_acquire) == expected) {
+        usleep(static_cast<useconds_t>(std::min(timeout_ms, 1) * 1000));
+    }
+#endif
+}
+
+void SharedMemoryTransport::futexWake(std::atomic<uint32_t>* addr) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)addr;
+#endif
+}
+
+SharedMemoryClient::~SharedMemoryClient() {
+    detach();
+}
+
+bool SharedMemoryClient::attach(const std::string& name) {
+    detach();
+
+    std::string shm_name = "/" + name;
+    fd_ = shm_open(shm_name.c_str(), O_RDWR, 0600);
+    if (fd_ < 0) {
+        std::cerr << "[SharedMemory] ERROR: shm_open failed for " << shm_name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < SHM_HEADER_SIZE) {
+        std::cerr << "[SharedMemory] ERROR: Invalid segment " << shm_name << std::endl;
+        detach();
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "[SharedMemory] ERROR: mmap failed: " << std::strerror(errno) << std::endl;
+        detach();
+        return false;
+    }
+
+    header_ = static_cast<SharedMemoryHeader*>(base);
+    if (header_->magic != SHM_MAGIC || header_->version != SHM_VERSION
+        || size_ < SHM_HEADER_SIZE + (header_->obs_capacity + header_->action_capacity) * sizeof(float)) {
+        std::cerr << "[SharedMemory] ERROR: Segment " << shm_name << " has an unknown layout" << std::endl;
+        detach();
+        return false;
+    }
+    observations_ = reinterpret_cast<float*>(static_cast<char*>(base) + SHM_HEADER_SIZE);
+    actions_ = observations_ + header_->obs_capacity;
+    return true;
+}
+
+void SharedMemoryClient::detach() {
+    if (header_) {
+        munmap(header_, size_);
+        header_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    observations_ = nullptr;
+    actions_ = nullptr;
+}
+
+bool SharedMemoryClient::step(const float* actions, size_t count, unsigned int substeps, int timeout_ms) {
+    if (!header_) return false;
+
+    std::memcpy(actions_, actions, std::min<size_t>(count, header_->action_capacity) * sizeof(float));
+    header_->substeps = substeps;
+    uint32_t seq = header_->request_seq.load(std::memory_order_relaxed) + 1;
+    header_->request_seq.store(seq, std::memory_order_release);
+    ring();
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (true) {
+        uint32_t reply = header_->reply_seq.load(std::memory_order_acquire);
+        if (header_->flags & SHM_FLAG_CLOSED) return false;
+        if (reply == seq) return true;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000L + (now.tv_nsec - start.tv_nsec) / 1000000L;
+        if (elapsed_ms > timeout_ms) return false;
+        SharedMemoryTransport::futexWait(&header_->reply_seq, reply, 1);
+    }
+}
+
+void SharedMemoryClient::notifyControl() {
+    if (!header_) return;
+    header_->control_seq.fetch_add(1, std::memory_order_release);
+    ring();
+}
+
+void SharedMemoryClient::ring() {
+    header_->wake_seq.fetch_add(1, std::memory_order_release);
+    SharedMemoryTransport::futexWake(&header_->wake_seq);
+}
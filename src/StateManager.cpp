@@ -1,319 +1,660 @@
 #include "StateManager.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 StateManager::StateManager() {
-    initializeExtractors();
     std::cout << "[StateManager] Dynamic StateManager initialized" << std::endl;
 }
 
 void StateManager::setObservationConfig(const ObservationConfig& config) {
     observation_config_ = config;
     observation_specs_ = config.specs;
+    observation_width_ = 0;
+    for (const auto& spec : observation_specs_) {
+        observation_width_ += spec.channel_count;
+    }
+    plan_.clear();
+    observation_buffer_.assign(observation_width_, 0.0f);
+    clearFilterCache();
+    history_length_ = std::max(1u, config.history_length);
+    history_actions_ = config.history_actions;
+    resizeHistory();
     std::cout << "[StateManager] Observation config set with " << observation_specs_.size() << " specs" << std::endl;
+    if (hasHistory()) {
+        std::cout << "[StateManager] History of " << history_length_ << " frames" 
+                  << (history_actions_ ? " with actions" : "") << std::endl;
+    }
     printObservationSpecs();
 }
 
-void StateManager::initializeExtractors() {
-    // Robot field extractors - explicitly cast double to float
-    
-    robot_extractors_ = {
-        {"position.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto robot = sim->getRobot(name);
-            return robot ? static_cast<float>(robot->getTransform().getOrigin().x()) : NAN;
-        }},
-        {"position.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto robot = sim->getRobot(name);
-            return robot ? static_cast<float>(robot->getTransform().getOrigin().y()) : NAN;
-        }},
-        {"position.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto robot = sim->getRobot(name);
-            return robot ? static_cast<float>(robot->getTransform().getOrigin().z()) : NAN;
-        }},
-        {"rotation.roll", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto robot = sim->getRobot(name);
-            if (!robot) return NAN;
-            sf::Scalar yaw, pitch, roll;
-            robot->getTransform().getRotation().getEulerZYX(yaw, pitch, roll);
-            return static_cast<float>(roll);
-        }},
-        {"rotation.pitch", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto robot = sim->getRobot(name);
-            if (!robot) return NAN;
-            sf::Scalar yaw, pitch, roll;
-            robot->getTransform().getRotation().getEulerZYX(yaw, pitch, roll);
-            return static_cast<float>(pitch);
-        }},
-        {"rotation.yaw", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto robot = sim->getRobot(name);
-            if (!robot) return NAN;
-            sf::Scalar yaw, pitch, roll;
-            robot->getTransform().getRotation().getEulerZYX(yaw, pitch, roll);
-            return static_cast<float>(yaw);
-        }},
-        {"collision.binary", [this](sf::SimulationManager* sim, const std::string& name) -> float {
-            return this->getCollisionFlag(sim, name);
-        }}
+const std::unordered_map<std::string, StateManager::RobotField>& StateManager::robotFields() {
+    static const std::unordered_map<std::string, RobotField> fields = {
+        {"position.x", RobotField::POSITION_X},
+        {"position.y", RobotField::POSITION_Y},
+        {"position.z", RobotField::POSITION_Z},
+        {"rotation.roll", RobotField::ROLL},
+        {"rotation.pitch", RobotField::PITCH},
+        {"rotation.yaw", RobotField::YAW}
     };
-    
-    // Add sensor and actuator extractors as needed...
-    // For now, using placeholder extractors
-    sensor_extractors_ = {
+    return fields;
+}
+
+const std::unordered_map<std::string, StateManager::SensorField>& StateManager::sensorFields() {
+    using T = sf::ScalarSensorType;
+    static const std::unordered_map<std::string, SensorField> fields = {
         // Generic sensor value extractors (fallback for any scalar sensor)
-        {"sensor.value", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto sensor_ptr = sim->getSensor(name);
-            sf::ScalarSensor *sensor = dynamic_cast<sf::ScalarSensor *>(sensor_ptr);
-            return sensor && sensor->getNumOfChannels() > 0 ? 
-                static_cast<float>(sensor->getLastSample().getValue(0)) : NAN;
-        }},
-        {"sensor.channel0", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto sensor_ptr = sim->getSensor(name);
-            sf::ScalarSensor *sensor = dynamic_cast<sf::ScalarSensor *>(sensor_ptr);
-            return sensor && sensor->getNumOfChannels() > 0 ? 
-                static_cast<float>(sensor->getLastSample().getValue(0)) : NAN;
-        }},
-        {"sensor.channel1", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            auto sensor_ptr = sim->getSensor(name);
-            sf::ScalarSensor *sensor = dynamic_cast<sf::ScalarSensor *>(sensor_ptr);
-            return sensor && sensor->getNumOfChannels() > 1 ? 
-                static_cast<float>(sensor->getLastSample().getValue(1)) : NAN;
-        }},
+        {"sensor.value", {T::ENCODER, 0, true}},
+        {"sensor.channel0", {T::ENCODER, 0, true}},
+        {"sensor.channel1", {T::ENCODER, 1, true}},
+        {"sensor.age", {T::ENCODER, 0, true, true}},
 
         // ENCODER SENSOR
-        {"encoder.angle", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ENCODER, 0);
-        }},
-        {"encoder.angular_velocity", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ENCODER, 1);
-        }},
+        {"encoder.angle", {T::ENCODER, 0, false}},
+        {"encoder.angular_velocity", {T::ENCODER, 1, false}},
 
         // ODOMETRY SENSOR - Complete mapping
-        {"odom.position.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 0);
-        }},
-        {"odom.position.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 1);
-        }},
-        {"odom.position.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 2);
-        }},
-        {"odom.linear_velocity.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 3);
-        }},
-        {"odom.linear_velocity.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 4);
-        }},
-        {"odom.linear_velocity.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 5);
-        }},
-        {"odom.rotation.roll", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 6);
-        }},
-        {"odom.rotation.pitch", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 7);
-        }},
-        {"odom.rotation.yaw", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 8);
-        }},
-        {"odom.angular_velocity.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 10);
-        }},
-        {"odom.angular_velocity.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 11);
-        }},
-        {"odom.angular_velocity.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::ODOM, 12);
-        }},
+        {"odom.position.x", {T::ODOM, 0, false}},
+        {"odom.position.y", {T::ODOM, 1, false}},
+        {"odom.position.z", {T::ODOM, 2, false}},
+        {"odom.linear_velocity.x", {T::ODOM, 3, false}},
+        {"odom.linear_velocity.y", {T::ODOM, 4, false}},
+        {"odom.linear_velocity.z", {T::ODOM, 5, false}},
+        {"odom.rotation.roll", {T::ODOM, 6, false}},
+        {"odom.rotation.pitch", {T::ODOM, 7, false}},
+        {"odom.rotation.yaw", {T::ODOM, 8, false}},
+        {"odom.angular_velocity.x", {T::ODOM, 10, false}},
+        {"odom.angular_velocity.y", {T::ODOM, 11, false}},
+        {"odom.angular_velocity.z", {T::ODOM, 12, false}},
 
         // PRESSURE SENSOR
-        {"pressure.value", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::PRESSURE, 0);
-        }},
-        {"pressure.depth", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::PRESSURE, 0);
-        }},
+        {"pressure.value", {T::PRESSURE, 0, false}},
+        {"pressure.depth", {T::PRESSURE, 0, false}},
 
         // FORCE_TORQUE SENSOR
-        {"ft.force.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::FT, 0);
-        }},
-        {"ft.force.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::FT, 1);
-        }},
-        {"ft.force.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::FT, 2);
-        }},
-        {"ft.torque.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::FT, 3);
-        }},
-        {"ft.torque.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::FT, 4);
-        }},
-        {"ft.torque.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::FT, 5);
-        }},
+        {"ft.force.x", {T::FT, 0, false}},
+        {"ft.force.y", {T::FT, 1, false}},
+        {"ft.force.z", {T::FT, 2, false}},
+        {"ft.torque.x", {T::FT, 3, false}},
+        {"ft.torque.y", {T::FT, 4, false}},
+        {"ft.torque.z", {T::FT, 5, false}},
 
         // GPS SENSOR
-        {"gps.latitude", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::GPS, 0);
-        }},
-        {"gps.longitude", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::GPS, 1);
-        }},
-        {"gps.north", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::GPS, 2);
-        }},
-        {"gps.east", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::GPS, 3);
-        }},
+        {"gps.latitude", {T::GPS, 0, false}},
+        {"gps.longitude", {T::GPS, 1, false}},
+        {"gps.north", {T::GPS, 2, false}},
+        {"gps.east", {T::GPS, 3, false}},
 
         // IMU SENSOR - Complete mapping
-        {"imu.rotation.roll", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 0);
-        }},
-        {"imu.rotation.pitch", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 1);
-        }},
-        {"imu.rotation.yaw", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 2);
-        }},
-        {"imu.angular_velocity.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 3);
-        }},
-        {"imu.angular_velocity.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 4);
-        }},
-        {"imu.angular_velocity.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 5);
-        }},
-        {"imu.linear_acceleration.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 6);
-        }},
-        {"imu.linear_acceleration.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 7);
-        }},
-        {"imu.linear_acceleration.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::IMU, 8);
-        }},
-
-        // DVL SENSOR (Doppler Velocity Log) - if available in your Stonefish version
-        {"dvl.velocity.x", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::DVL, 0);
-        }},
-        {"dvl.velocity.y", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::DVL, 1);
-        }},
-        {"dvl.velocity.z", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::DVL, 2);
-        }},
-        {"dvl.altitude", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::DVL, 3);
-        }},
-
-        // PROFILER SENSOR - if available
-        {"profiler.range", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::PROFILER, 0);
-        }},
-
-        // MULTIBEAM SENSOR - if available  
-        {"multibeam.range", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            return extractFromSensorType(sim, name, sf::ScalarSensorType::MULTIBEAM, 0);
-        }}
+        {"imu.rotation.roll", {T::IMU, 0, false}},
+        {"imu.rotation.pitch", {T::IMU, 1, false}},
+        {"imu.rotation.yaw", {T::IMU, 2, false}},
+        {"imu.angular_velocity.x", {T::IMU, 3, false}},
+        {"imu.angular_velocity.y", {T::IMU, 4, false}},
+        {"imu.angular_velocity.z", {T::IMU, 5, false}},
+        {"imu.linear_acceleration.x", {T::IMU, 6, false}},
+        {"imu.linear_acceleration.y", {T::IMU, 7, false}},
+        {"imu.linear_acceleration.z", {T::IMU, 8, false}},
+
+        // DVL SENSOR (Doppler Velocity Log)
+        {"dvl.velocity.x", {T::DVL, 0, false}},
+        {"dvl.velocity.y", {T::DVL, 1, false}},
+        {"dvl.velocity.z", {T::DVL, 2, false}},
+        {"dvl.altitude", {T::DVL, 3, false}},
+
+        // PROFILER SENSOR
+        {"profiler.range", {T::PROFILER, 0, false}},
+
+        // MULTIBEAM SENSOR
+        {"multibeam.range", {T::MULTIBEAM, 0, false}}
     };
-    
-    actuator_extractors_ = {
-        {"setpoint", [](sf::SimulationManager* sim, const std::string& name) -> float {
-            // Generic actuator value extractor
-            return 0.0f;
-        }}
+    return fields;
+}
+
+const std::unordered_map<std::string, StateManager::ActuatorField>& StateManager::actuatorFields() {
+    static const std::unordered_map<std::string, ActuatorField> fields = {
+        // SERVO
+        {"servo.position", ActuatorField::SERVO_POSITION},
+        {"servo.velocity", ActuatorField::SERVO_VELOCITY},
+        {"servo.effort", ActuatorField::SERVO_EFFORT},
+
+        // THRUSTER
+        {"thruster.omega", ActuatorField::THRUSTER_OMEGA},
+        {"thruster.thrust", ActuatorField::THRUSTER_THRUST},
+        {"thruster.torque", ActuatorField::THRUSTER_TORQUE},
+        {"thruster.setpoint", ActuatorField::THRUSTER_SETPOINT}
     };
+    return fields;
 }
 
-// Helper function
-float StateManager::extractFromSensorType(sf::SimulationManager* sim, const std::string& name, 
-                           sf::ScalarSensorType expected_type, int channel_index) {
-    auto sensor_ptr = sim->getSensor(name);
-    sf::ScalarSensor* sensor = dynamic_cast<sf::ScalarSensor*>(sensor_ptr);
-    if (!sensor || sensor->getScalarSensorType() != expected_type) 
-        return NAN;
-    if (channel_index >= sensor->getNumOfChannels()) 
-        return NAN;
-    return static_cast<float>(sensor->getLastSample().getValue(channel_index));
+const std::unordered_map<std::string, StateManager::CollisionField>& StateManager::collisionFields() {
+    static const std::unordered_map<std::string, CollisionField> fields = {
+        {"binary", CollisionField::FLAG},
+        {"contacts", CollisionField::CONTACTS},
+        {"impulse", CollisionField::IMPULSE}
+    };
+    return fields;
 }
 
-std::vector<float> StateManager::getObservationVector(sf::SimulationManager* sim) {
-    std::vector<float> observations;
-    observations.reserve(observation_specs_.size());
-    
-    for (const auto& spec : observation_specs_) {
-        float value = NAN;
-        
-        // Determine entity type and extract accordingly
+const std::unordered_map<std::string, StateManager::Aggregate>& StateManager::aggregates() {
+    static const std::unordered_map<std::string, Aggregate> modes = {
+        {"", Aggregate::LAST},
+        {"last", Aggregate::LAST},
+        {"mean", Aggregate::MEAN},
+        {"min", Aggregate::MIN},
+        {"max", Aggregate::MAX},
+        {"integral", Aggregate::INTEGRAL}
+    };
+    return modes;
+}
+
+size_t StateManager::robotSlot(sf::Robot* robot) {
+    for (size_t i = 0; i < robot_slots_.size(); ++i) {
+        if (robot_slots_[i].robot == robot) return i;
+    }
+    RobotSlot slot;
+    slot.robot = robot;
+    slot.name = robot->getName();
+    robot_slots_.push_back(slot);
+    return robot_slots_.size() - 1;
+}
+
+size_t StateManager::sensorSlot(sf::ScalarSensor* sensor) {
+    for (size_t i = 0; i < sensor_slots_.size(); ++i) {
+        if (sensor_slots_[i].sensor == sensor) return i;
+    }
+    SensorSlot slot;
+    slot.sensor = sensor;
+    sensor_slots_.push_back(slot);
+    return sensor_slots_.size() - 1;
+}
+
+size_t StateManager::actuatorSlot(sf::Servo* servo, sf::Thruster* thruster) {
+    for (size_t i = 0; i < actuator_slots_.size(); ++i) {
+        if (actuator_slots_[i].servo == servo && actuator_slots_[i].thruster == thruster) return i;
+    }
+    ActuatorSlot slot;
+    slot.servo = servo;
+    slot.thruster = thruster;
+    actuator_slots_.push_back(slot);
+    return actuator_slots_.size() - 1;
+}
+
+size_t StateManager::collisionSlot(sf::Robot* robot) {
+    for (size_t i = 0; i < collision_robots_.size(); ++i) {
+        if (collision_robots_[i] == robot) return i;
+    }
+    collision_robots_.push_back(robot);
+    return collision_robots_.size() - 1;
+}
+
+void StateManager::compileObservationPlan(sf::SimulationManager* sim) {
+    plan_.assign(observation_specs_.size(), CompiledObservation());
+    robot_slots_.clear();
+    sensor_slots_.clear();
+    actuator_slots_.clear();
+    collision_robots_.clear();
+    observation_buffer_.assign(observation_width_, 0.0f);
+    clearFilterCache();
+    size_t unresolved = 0;
+
+    for (size_t i = 0; i < observation_specs_.size(); ++i) {
+        const ObservationSpec& spec = observation_specs_[i];
+        CompiledObservation& entry = plan_[i];
+        entry.count = spec.channel_count;
+        entry.stride = spec.channel_stride;
+        std::string field_key = spec.field_type + "." + spec.component;
+        // Channel ranges are read from one sensor sample, every other source is scalar
+        bool range = entry.count > 1 || spec.channel_start >= 0;
+
+        // Determine entity type once, the same order the specs were always resolved in
         if (spec.field_type == "collision") {
-            value = getCollisionFlag(sim, spec.entity_name);
+            sf::Robot* robot = findRobot(sim, spec.entity_name);
+            auto field = collisionFields().find(spec.component);
+            if (!robot) {
+                std::cerr << "[StateManager] WARNING: Robot not found for collision: " << spec.entity_name << std::endl;
+            } else if (field == collisionFields().end()) {
+                std::cerr << "[StateManager] WARNING: No collision field: " << field_key 
+                          << " for " << spec.entity_name << std::endl;
+            } else {
+                entry.source = ObservationSource::COLLISION;
+                entry.slot = collisionSlot(robot);
+                entry.channel = static_cast<unsigned int>(field->second);
+            }
         }
-        else if (findRobot(sim, spec.entity_name)) {
-            value = extractRobotField(sim, spec);
+        else if (sf::Robot* robot = findRobot(sim, spec.entity_name)) {
+            auto field = robotFields().find(field_key);
+            if (field != robotFields().end()) {
+                entry.source = ObservationSource::ROBOT;
+                entry.slot = robotSlot(robot);
+                entry.channel = static_cast<unsigned int>(field->second);
+                if (field->second == RobotField::ROLL || field->second == RobotField::PITCH 
+                    || field->second == RobotField::YAW) {
+                    robot_slots_[entry.slot].needs_euler = true;
+                }
+            } else {
+                std::cerr << "[StateManager] WARNING: No robot field: " << field_key 
+                          << " for " << spec.entity_name << std::endl;
+            }
         }
-        else if (findSensor(sim, spec.entity_name)) {
-            value = extractSensorField(sim, spec);
+        else if (sf::Sensor* sensor_ptr = findSensor(sim, spec.entity_name)) {
+            sf::ScalarSensor* sensor = dynamic_cast<sf::ScalarSensor*>(sensor_ptr);
+            auto field = sensorFields().find(field_key);
+            if (!sensor) {
+                std::cerr << "[StateManager] WARNING: Sensor is not a scalar sensor: " << spec.entity_name << std::endl;
+            }
+            else if (field == sensorFields().end()) {
+                std::cerr << "[StateManager] WARNING: No sensor field: " << field_key 
+                          << " for " << spec.entity_name << std::endl;
+            }
+            else if (!field->second.any_type && sensor->getScalarSensorType() != field->second.type) {
+                std::cerr << "[StateManager] WARNING: Sensor " << spec.entity_name 
+                          << " does not provide field " << field_key << std::endl;
+            }
+            else if (field->second.age) {
+                if (range) {
+                    std::cerr << "[StateManager] WARNING: No channel range for " << field_key << std::endl;
+                } else {
+                    entry.source = ObservationSource::SENSOR_AGE;
+                    entry.slot = sensorSlot(sensor);
+                }
+            }
+            else {
+                unsigned int first = spec.channel_start >= 0 ? static_cast<unsigned int>(spec.channel_start) 
+                                                             : field->second.channel;
+                unsigned int last = first + (entry.count - 1) * entry.stride;
+                if (last >= sensor->getNumOfChannels()) {
+                    std::cerr << "[StateManager] WARNING: Sensor " << spec.entity_name << " has no channel " 
+                              << last << " for field " << field_key << std::endl;
+                } else {
+                    entry.source = ObservationSource::SENSOR;
+                    entry.slot = sensorSlot(sensor);
+                    entry.channel = first;
+                    SensorSlot& slot = sensor_slots_[entry.slot];
+                    slot.num_channels = std::max(slot.num_channels, last + 1);
+                }
+            }
         }
-        else if (findActuator(sim, spec.entity_name)) {
-            value = extractActuatorField(sim, spec);
+        else if (sf::Actuator* actuator = findActuator(sim, spec.entity_name)) {
+            auto field = actuatorFields().find(field_key);
+            sf::Servo* servo = actuator->getType() == sf::ActuatorType::SERVO 
+                ? dynamic_cast<sf::Servo*>(actuator) : nullptr;
+            sf::Thruster* thruster = actuator->getType() == sf::ActuatorType::THRUSTER 
+                ? dynamic_cast<sf::Thruster*>(actuator) : nullptr;
+            if (field == actuatorFields().end()) {
+                std::cerr << "[StateManager] WARNING: No actuator field: " << field_key 
+                          << " for " << spec.entity_name << std::endl;
+            }
+            else if ((field->second <= ActuatorField::SERVO_EFFORT && !servo) 
+                     || (field->second >= ActuatorField::THRUSTER_OMEGA && !thruster)) {
+                std::cerr << "[StateManager] WARNING: Actuator " << spec.entity_name 
+                          << " does not provide field " << field_key << std::endl;
+            }
+            else {
+                entry.source = ObservationSource::ACTUATOR;
+                entry.slot = actuatorSlot(servo, thruster);
+                entry.channel = static_cast<unsigned int>(field->second);
+            }
         }
         else {
             std::cerr << "[StateManager] WARNING: Entity not found: " << spec.entity_name << std::endl;
-            value = 0.0f; // Default to 0 instead of NaN for robustness
         }
-        
-        observations.push_back(value);
+
+        if (range && entry.source != ObservationSource::SENSOR && entry.source != ObservationSource::INVALID) {
+            std::cerr << "[StateManager] WARNING: Channel ranges are only supported for sensors: " 
+                      << spec.output_name << std::endl;
+            entry.source = ObservationSource::INVALID;
+        }
+        if (entry.source == ObservationSource::INVALID) {
+            ++unresolved;
+        }
+    }
+
+    for (auto& slot : sensor_slots_) {
+        slot.values.assign(slot.num_channels, 0.0f);
+    }
+    collision_monitor_.configure(sim, collision_robots_, observation_config_.collision_targets);
+    compileAggregates();
+
+    std::cout << "[StateManager] Observation plan compiled: " << plan_.size() << " specs, "
+              << robot_slots_.size() << " robots, " << sensor_slots_.size() << " sensors";
+    if (!actuator_slots_.empty()) {
+        std::cout << ", " << actuator_slots_.size() << " actuators";
+    }
+    if (!aggregated_entries_.empty()) {
+        std::cout << ", " << aggregated_entries_.size() << " aggregated";
+    }
+    if (unresolved > 0) {
+        std::cout << ", " << unresolved << " unresolved (reported as 0)";
+    }
+    std::cout << std::endl;
+}
+
+void StateManager::compileAggregates() {
+    aggregated_entries_.clear();
+    aggregate_robot_slots_.assign(robot_slots_.size(), 0);
+    aggregate_sensor_slots_.assign(sensor_slots_.size(), 0);
+
+    for (size_t i = 0; i < plan_.size(); ++i) {
+        const ObservationSpec& spec = observation_specs_[i];
+        CompiledObservation& entry = plan_[i];
+        auto mode = aggregates().find(spec.aggregate);
+        if (mode == aggregates().end()) {
+            std::cerr << "[StateManager] WARNING: Unknown aggregate '" << spec.aggregate << "' for " 
+                      << spec.output_name << ", using the last value" << std::endl;
+            continue;
+        }
+        if (mode->second == Aggregate::LAST) continue;
+        // Euler angles wrap at +-pi, their mean, min, max and integral would jump by 2 pi
+        if ((spec.field_type + "." + spec.component).find("rotation.") != std::string::npos) {
+            std::cerr << "[StateManager] WARNING: Aggregates are not supported for wrapped angles: " 
+                      << spec.output_name << ", using the last value" << std::endl;
+            continue;
+        }
+        if (entry.count > 1) {
+            std::cerr << "[StateManager] WARNING: Aggregates are not supported for channel ranges: " 
+                      << spec.output_name << std::endl;
+            continue;
+        }
+        // Collision fields are already per interval, sample ages are not aggregated
+        if (entry.source == ObservationSource::ROBOT) {
+            aggregate_robot_slots_[entry.slot] = 1;
+        } else if (entry.source == ObservationSource::SENSOR) {
+            aggregate_sensor_slots_[entry.slot] = 1;
+        } else if (entry.source != ObservationSource::ACTUATOR) {
+            std::cerr << "[StateManager] WARNING: Aggregate '" << spec.aggregate << "' not supported for " 
+                      << spec.output_name << std::endl;
+            continue;
+        }
+        entry.aggregate = mode->second;
+        entry.accumulator = aggregated_entries_.size();
+        aggregated_entries_.push_back(i);
+    }
+
+    aggregate_values_.assign(aggregated_entries_.size(), 0.0f);
+    accumulators_.resize(aggregated_entries_.size());
+}
+
+void StateManager::updateAggregates(sf::SimulationManager* sim, float dt) {
+    if (aggregated_entries_.empty()) return;
+    refreshRobotSlots(&aggregate_robot_slots_);
+    refreshSensorSlots(static_cast<double>(sim->getSimulationTime()), &aggregate_sensor_slots_);
+
+    size_t n = aggregated_entries_.size();
+    float* values = aggregate_values_.data();
+    for (size_t k = 0; k < n; ++k) {
+        values[k] = readValue(plan_[aggregated_entries_[k]]);
+    }
+    accumulators_.add(values, dt);
+}
+
+void StateManager::resetAggregates() {
+    accumulators_.reset();
+}
+
+void StateManager::refreshRobotSlots(const std::vector<char>* used) {
+    for (size_t i = 0; i < robot_slots_.size(); ++i) {
+        if (used && !(*used)[i]) continue;
+        RobotSlot& slot = robot_slots_[i];
+        sf::Transform tf = slot.robot->getTransform();
+        const sf::Vector3& origin = tf.getOrigin();
+        slot.position[0] = static_cast<float>(origin.x());
+        slot.position[1] = static_cast<float>(origin.y());
+        slot.position[2] = static_cast<float>(origin.z());
+        if (slot.needs_euler) {
+            sf::Scalar yaw, pitch, roll;
+            tf.getRotation().getEulerZYX(yaw, pitch, roll);
+            slot.euler[0] = static_cast<float>(roll);
+            slot.euler[1] = static_cast<float>(pitch);
+            slot.euler[2] = static_cast<float>(yaw);
+        }
+    }
+}
+
+void StateManager::refreshSensorSlots(double sim_time, const std::vector<char>* used) {
+    for (size_t i = 0; i < sensor_slots_.size(); ++i) {
+        if (used && !(*used)[i]) continue;
+        SensorSlot& slot = sensor_slots_[i];
+        // Sensors slower than the physics keep their sample for several steps
+        if (!slot.cached || slot.sensor->isNewDataAvailable()) {
+            sf::Sample sample = slot.sensor->getLastSample();
+            for (unsigned int ch = 0; ch < slot.num_channels; ++ch) {
+                slot.values[ch] = static_cast<float>(sample.getValue(ch));
+            }
+            slot.timestamp = static_cast<double>(sample.getTimestamp());
+            slot.sensor->MarkDataOld();
+            slot.cached = true;
+        }
+        slot.age = static_cast<float>(std::max(0.0, sim_time - slot.timestamp));
+    }
+}
+
+void StateManager::invalidateSensorCache() {
+    for (auto& slot : sensor_slots_) {
+        slot.cached = false;
+    }
+}
+
+float StateManager::readEntry(const CompiledObservation& entry) const {
+    if (entry.aggregate == Aggregate::LAST) {
+        return readValue(entry);
+    }
+    size_t k = entry.accumulator;
+    // No physics step since the interval started (reset reply): the current value
+    bool stepped = accumulators_.getSteps() > 0;
+    switch (entry.aggregate) {
+    case Aggregate::INTEGRAL:
+        return accumulators_.getIntegral(k);
+    case Aggregate::MEAN:
+        return stepped ? accumulators_.getMean(k) : readValue(entry);
+    case Aggregate::MIN:
+        return stepped ? accumulators_.getMin(k) : readValue(entry);
+    case Aggregate::MAX:
+        return stepped ? accumulators_.getMax(k) : readValue(entry);
+    default:
+        return readValue(entry);
+    }
+}
+
+float* StateManager::writeEntry(const CompiledObservation& entry, float* out) const {
+    if (entry.count == 1) {
+        *out = readEntry(entry);
+        return out + 1;
+    }
+    if (entry.source != ObservationSource::SENSOR) {
+        std::fill(out, out + entry.count, 0.0f);
+        return out + entry.count;
+    }
+    // Channel range of the cached sample, one contiguous copy unless downsampled
+    const float* values = sensor_slots_[entry.slot].values.data() + entry.channel;
+    if (entry.stride == 1) {
+        std::copy(values, values + entry.count, out);
+    } else {
+        for (unsigned int k = 0; k < entry.count; ++k) {
+            out[k] = values[k * entry.stride];
+        }
+    }
+    return out + entry.count;
+}
+
+float StateManager::readValue(const CompiledObservation& entry) const {
+    switch (entry.source) {
+    case ObservationSource::ROBOT: {
+        const RobotSlot& slot = robot_slots_[entry.slot];
+        return entry.channel <= static_cast<unsigned int>(RobotField::POSITION_Z)
+            ? slot.position[entry.channel]
+            : slot.euler[entry.channel - static_cast<unsigned int>(RobotField::ROLL)];
+    }
+    case ObservationSource::SENSOR:
+        return sensor_slots_[entry.slot].values[entry.channel];
+    case ObservationSource::SENSOR_AGE:
+        return sensor_slots_[entry.slot].age;
+    case ObservationSource::ACTUATOR: {
+        const ActuatorSlot& slot = actuator_slots_[entry.slot];
+        switch (static_cast<ActuatorField>(entry.channel)) {
+        case ActuatorField::SERVO_POSITION:    return static_cast<float>(slot.servo->getPosition());
+        case ActuatorField::SERVO_VELOCITY:    return static_cast<float>(slot.servo->getVelocity());
+        case ActuatorField::SERVO_EFFORT:      return static_cast<float>(slot.servo->getEffort());
+        case ActuatorField::THRUSTER_OMEGA:    return static_cast<float>(slot.thruster->getOmega());
+        case ActuatorField::THRUSTER_THRUST:   return static_cast<float>(slot.thruster->getThrust());
+        case ActuatorField::THRUSTER_TORQUE:   return static_cast<float>(slot.thruster->getTorque());
+        case ActuatorField::THRUSTER_SETPOINT: return static_cast<float>(slot.thruster->getSetpoint());
+        }
+        return 0.0f;
+    }
+    case ObservationSource::COLLISION:
+        switch (static_cast<CollisionField>(entry.channel)) {
+        case CollisionField::FLAG:     return collision_monitor_.getFlag(entry.slot);
+        case CollisionField::CONTACTS: return collision_monitor_.getContactCount(entry.slot);
+        case CollisionField::IMPULSE:  return collision_monitor_.getImpulse(entry.slot);
+        }
+        return 0.0f;
+    default:
+        return 0.0f; // Default to 0 instead of NaN for robustness
+    }
+}
+
+const std::vector<float>& StateManager::getObservationVector(sf::SimulationManager* sim, bool extract_all) {
+    if (plan_.size() != observation_specs_.size()) {
+        compileObservationPlan(sim);
+    }
+    
+    double sim_time = static_cast<double>(sim->getSimulationTime());
+    const ObservationFilter* filter = active_filter_;
+    if (filter && !extract_all) {
+        // Only the slots and entries of the selection are read
+        refreshRobotSlots(&filter->robot_slots);
+        refreshSensorSlots(sim_time, &filter->sensor_slots);
+        float* out = selection_.begin(filter->count);
+        for (size_t word = 0; word < filter->bits.size(); ++word) {
+            uint64_t bits = filter->bits[word];
+            while (bits) {
+                size_t i = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                out = writeEntry(plan_[i], out);
+                bits &= bits - 1;
+            }
+        }
+        return selection_.get();
+    }
+    
+    // Every robot transform and sensor sample is read once
+    refreshRobotSlots();
+    refreshSensorSlots(sim_time);
+    
+    float* out = observation_buffer_.data();
+    for (size_t i = 0; i < plan_.size(); ++i) {
+        out = writeEntry(plan_[i], out);
+    }
+    if (!filter) {
+        return observation_buffer_;
     }
     
-    return observations;
+    // Full vector kept (getUnfilteredObservationVector), the reply gets the selection
+    return selection_.gather(filter->ranges, observation_buffer_.data());
 }
 
-float StateManager::extractRobotField(sf::SimulationManager* sim, const ObservationSpec& spec) {
-    std::string field_key = spec.field_type + "." + spec.component;
-    auto extractor = robot_extractors_.find(field_key);
+bool StateManager::selectObservations(const std::string& filter) {
+    if (filter.empty()) {
+        active_filter_ = nullptr;
+        return true;
+    }
+    // Same filter as the previous command: no lookup at all
+    if (last_filter_ && filter == last_filter_key_) {
+        active_filter_ = last_filter_;
+        return active_filter_->count > 0;
+    }
     
-    if (extractor != robot_extractors_.end()) {
-        try {
-            return extractor->second(sim, spec.entity_name);
-        } catch (const std::exception& e) {
-            std::cerr << "[StateManager] ERROR extracting " << field_key << " from " 
-                      << spec.entity_name << ": " << e.what() << std::endl;
+    auto it = filter_cache_.find(filter);
+    if (it == filter_cache_.end()) {
+        if (filter_cache_.size() >= MAX_CACHED_FILTERS) {
+            clearFilterCache();
         }
-    } else {
-        std::cerr << "[StateManager] WARNING: No extractor for field: " << field_key << std::endl;
+        it = filter_cache_.emplace(filter, compileFilter(filter)).first;
     }
+    last_filter_key_ = filter;
+    last_filter_ = &it->second;
+    active_filter_ = last_filter_;
+    return active_filter_->count > 0;
+}
+
+void StateManager::clearFilterCache() {
+    filter_cache_.clear();
+    active_filter_ = nullptr;
+    last_filter_ = nullptr;
+    last_filter_key_.clear();
+}
+
+StateManager::ObservationFilter StateManager::compileFilter(const std::string& filter) const {
+    ObservationFilter compiled;
+    compiled.bits.assign((plan_.size() + 63) / 64, 0);
+    compiled.robot_slots.assign(robot_slots_.size(), 0);
+    compiled.sensor_slots.assign(sensor_slots_.size(), 0);
     
-    return 0.0f;
-}
-
-float StateManager::extractSensorField(sf::SimulationManager* sim, const ObservationSpec& spec) {
-    std::string field_key = spec.field_type + "." + spec.component;
-    auto extractor = sensor_extractors_.find(field_key);
-    if (extractor != sensor_extractors_.end()) {
-        try {
-            return extractor->second(sim, spec.entity_name);
-        } catch (const std::exception& e) {
-            std::cerr << "[StateManager] ERROR extracting " << field_key << " from " 
-                      << spec.entity_name << ": " << e.what() << std::endl;
+    // "name;name" (or ','), a name is an output_name or an entity_name (all its specs)
+    size_t start = 0;
+    while (start <= filter.size()) {
+        size_t end = filter.find_first_of(";,", start);
+        if (end == std::string::npos) end = filter.size();
+        std::string name = filter.substr(start, end - start);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        start = end + 1;
+        if (name.empty()) continue;
+        
+        bool matched = false;
+        for (size_t i = 0; i < observation_specs_.size() && i < plan_.size(); ++i) {
+            const ObservationSpec& spec = observation_specs_[i];
+            if (spec.output_name != name && spec.entity_name != name) continue;
+            matched = true;
+            compiled.bits[i / 64] |= uint64_t(1) << (i % 64);
+            if (plan_[i].source == ObservationSource::ROBOT) compiled.robot_slots[plan_[i].slot] = 1;
+            if (plan_[i].source == ObservationSource::SENSOR || plan_[i].source == ObservationSource::SENSOR_AGE) {
+                compiled.sensor_slots[plan_[i].slot] = 1;
+            }
         }
-    } else {
-        std::cerr << "[StateManager] WARNING: No extractor for field: " << field_key << std::endl;
+        if (!matched) {
+            std::cerr << "[StateManager] WARNING: Observation filter '" << name 
+                      << "' matches no observation spec" << std::endl;
+        }
+    }
+    
+    size_t offset = 0;
+    for (size_t i = 0; i < plan_.size(); ++i) {
+        if (compiled.bits[i / 64] & (uint64_t(1) << (i % 64))) {
+            ObservationSelection::addRange(compiled.ranges, offset, plan_[i].count);
+            compiled.count += plan_[i].count;
+        }
+        offset += plan_[i].count;
     }
-    // // Implement sensor field extraction
-    // std::cerr << "[StateManager] WARNING: Sensor extraction not yet implemented for " 
-    //           << spec.entity_name << std::endl;
-    return 0.0f;
+    return compiled;
+}
+
+void StateManager::setActionNames(const std::vector<std::string>& names) {
+    action_names_ = names;
+    resizeHistory();
+}
+
+void StateManager::resizeHistory() {
+    history_.resize(history_length_, observation_width_ + (history_actions_ ? action_names_.size() : 0));
+}
+
+const std::vector<float>& StateManager::pushHistory(const std::vector<float>& actions, bool reset) {
+    // Zero actions before the first step of an episode
+    size_t num_actions = history_actions_ && !reset ? actions.size() : 0;
+    return history_.push(observation_buffer_.data(), observation_width_, actions.data(), num_actions, reset);
 }
 
-float StateManager::extractActuatorField(sf::SimulationManager* sim, const ObservationSpec& spec) {
-    // Implement actuator field extraction  
-    std::cerr << "[StateManager] WARNING: Actuator extraction not yet implemented for " 
-              << spec.entity_name << std::endl;
-    return 0.0f;
+void StateManager::updateCollisions(sf::SimulationManager* sim) {
+    collision_monitor_.update(sim);
+}
+
+size_t StateManager::watchCollisions(sf::SimulationManager* sim, sf::Robot* robot) {
+    size_t count = collision_robots_.size();
+    size_t slot = collisionSlot(robot);
+    if (collision_robots_.size() != count) {
+        collision_monitor_.configure(sim, collision_robots_, observation_config_.collision_targets);
+    }
+    return slot;
 }
 
 // Entity finding methods
@@ -350,6 +691,9 @@ void StateManager::updateRobotPosition(const std::vector<RobotResetInfo>& robot_
     for (const auto& info : robot_info) {
         positionSingleRobot(info, sim);
     }
+    // Contacts and aggregates from before the reset must not leak into the first observation
+    collision_monitor_.beginInterval();
+    resetAggregates();
 }
 
 void StateManager::positionSingleRobot(const RobotResetInfo& info, sf::SimulationManager* sim) {
@@ -386,17 +730,31 @@ void StateManager::positionSingleRobot(const RobotResetInfo& info, sf::Simulatio
     std::cout << "[StateManager] Repositioned robot: " << info.name << std::endl;
 }
 
-float StateManager::getCollisionFlag(sf::SimulationManager* sim, const std::string& robot_name) {
-    // Simplified collision detection - implement your logic here
-    // Return 1.0 for collision, 0.0 for no collision
-    // This is a placeholder - you'll need to implement proper collision detection
-    return 0.0f;
-}
-
-std::vector<std::string> StateManager::getObservationNames() const {
-    std::vector<std::string> names;
+std::vector<std::string> StateManager::getObservationNames(bool stacked) const {
+    // Channel ranges are named "name[i]"
+    std::vector<std::string> frame;
     for (const auto& spec : observation_specs_) {
-        names.push_back(spec.output_name);
+        if (spec.channel_count == 1 && spec.channel_start < 0) {
+            frame.push_back(spec.output_name);
+            continue;
+        }
+        for (unsigned int k = 0; k < spec.channel_count; ++k) {
+            frame.push_back(spec.output_name + "[" + std::to_string(k) + "]");
+        }
+    }
+    if (!stacked || !hasHistory()) {
+        return frame;
+    }
+    if (history_actions_) {
+        frame.insert(frame.end(), action_names_.begin(), action_names_.end());
+    }
+    // Oldest frame first, "name@-k" for the frame k steps before the current one
+    std::vector<std::string> names;
+    for (size_t lag = history_length_; lag-- > 0;) {
+        std::string suffix = lag > 0 ? "@-" + std::to_string(lag) : "";
+        for (const auto& name : frame) {
+            names.push_back(name + suffix);
+        }
     }
     return names;
 }
@@ -405,6 +763,10 @@ void StateManager::printObservationSpecs() const {
     std::cout << "[StateManager] Observation Specifications:" << std::endl;
     for (const auto& spec : observation_specs_) {
         std::cout << "  " << spec.output_name << " <- " << spec.entity_name 
-                  << "." << spec.field_type << "." << spec.component << std::endl;
+                  << "." << spec.field_type << "." << spec.component;
+        if (!spec.aggregate.empty()) {
+            std::cout << " (" << spec.aggregate << ")";
+        }
+        std::cout << std::endl;
     }
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "StepProfiler.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+
+static const char* PHASE_NAMES[] = {"receive", "parse", "apply", "step", "observe", "send"};
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<size_t>(StepPhase::COUNT), 
+              "Every StepPhase needs a name");
+
+int LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns < SUB_BUCKETS) return static_cast<int>(ns);
+
+    int msb = 63 - __builtin_clzll(ns);
+    if (msb >= MAX_BITS) return NUM_BUCKETS - 1;
+    int shift = msb - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<int>((ns >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    ++buckets_[bucketIndex(ns)];
+    ++count_;
+    max_ = std::max(max_, ns);
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    max_ = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(count_)));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= target) {
+            return std::min(bucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+StepProfiler::StepProfiler() {
+    reset();
+}
+
+void StepProfiler::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+    steps_ = 0;
+    physics_steps_ = 0;
+    since_ = Clock::now();
+}
+
+std::string StepProfiler::report() const {
+    double elapsed = std::chrono::duration<double>(Clock::now() - since_).count();
+
+    nlohmann::json j;
+    j["elapsed_s"] = elapsed;
+    j["steps"] = steps_;
+    j["physics_steps"] = physics_steps_;
+    j["steps_per_s"] = elapsed > 0.0 ? steps_ / elapsed : 0.0;
+    j["physics_steps_per_s"] = elapsed > 0.0 ? physics_steps_ / elapsed : 0.0;
+
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        const LatencyHistogram& h = histograms_[i];
+        j["phases"][PHASE_NAMES[i]] = {
+            {"count", h.getCount()},
+            {"p50_us", h.percentile(50.0) / 1000.0},
+            {"p90_us", h.percentile(90.0) / 1000.0},
+            {"p99_us", h.percentile(99.0) / 1000.0},
+            {"max_us", h.getMax() / 1000.0}
+        };
+    }
+    return j.dump();
+}
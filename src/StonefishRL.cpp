@@ -1,14 +1,24 @@
 #include "StonefishRL.h"
 #include <iostream>
 #include <sstream>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
 
 // Constructor
-StonefishRL::StonefishRL(const std::string &path, const std::string &observation_conf_path,const std::string &action_conf_path, double frequency)
+StonefishRL::StonefishRL(const std::string &path, const std::string &observation_conf_path,const std::string &action_conf_path, 
+                         double frequency, const std::string &address, bool async_mode)
     : sf::SimulationManager(frequency),
       scenePath(path),
-      communicator(nullptr)
+      frequency_(frequency),
+      communicator(nullptr),
+      async_mode_(async_mode)
 {
-    communicator = new ZMQCommunicator("tcp://*:5555");
+    if (!address.empty()) {
+        communicator = new ZMQCommunicator(address, async_mode ? SocketMode::ROUTER : SocketMode::REPLY);
+    }
     std::cout << "[StonefishRL] Initialized with scene: " << scenePath << std::endl;
 
      // Load observation configuration
@@ -16,40 +26,174 @@ StonefishRL::StonefishRL(const std::string &path, const std::string &observation
     ObservationConfig config = loader.loadFromFile(observation_conf_path);
     state_manager_.setObservationConfig(config);
     
+    // Load action configuration (default substeps per command)
+    action_config_ = loader.loadActionConfigFromFile(action_conf_path);
+    control_pipeline_.setConfig(action_config_.controllers);
+    std::vector<std::string> action_names;
+    for (const auto& spec : action_config_.specs) {
+        action_names.push_back(spec.output_name);
+    }
+    state_manager_.setActionNames(action_names);
+    
+    // Optional reward/termination terms and reset distributions, next to the observation config
+    reward_engine_.setConfig(loader.loadRewardConfigFromFile(observation_conf_path));
+    reset_sampler_.setConfig(loader.loadResetConfigFromFile(observation_conf_path));
+    
     std::cout << "[StonefishRL] Initialized with scene: " << scenePath << std::endl;
 
 }
 
 std::string StonefishRL::RecieveInstructions(sf::SimulationApp& simApp) {
     zmq::message_t request;
-    auto result = communicator->receive(request, zmq::recv_flags::none);
+    auto t_receive = StepProfiler::now();
+    if (shm_transport_.isOpen()) {
+        // Steps arrive through the shared memory doorbell, ZMQ only carries control commands.
+        // The client rings the same doorbell before a control request, so both are served from one futex sleep
+        while (true) {
+            ShmWake wake = shm_transport_.waitRequest(SHM_CONTROL_FALLBACK_MS);
+            if (wake == ShmWake::STEP) {
+                profiler_.record(StepPhase::RECEIVE, t_receive);
+                auto t_apply = StepProfiler::now();
+                actuator_controller_.applyActionVector(shm_transport_.getActions(), shm_transport_.getActionCount());
+                profiler_.record(StepPhase::APPLY, t_apply);
+                shm_step_pending_ = true;
+                // The segment has no error reply, an oversized request is held for max_substeps
+                pending_substeps_ = shm_transport_.getSubsteps();
+                if (!CheckSubsteps(pending_substeps_)) {
+                    pending_substeps_ = action_config_.max_substeps;
+                }
+                recorder_.writeInput(LogRecordType::ACTION, getSubsteps(), getSimulationTime(), 
+                                     shm_transport_.getActions(), shm_transport_.getActionCount() * sizeof(float));
+                return "CMD";
+            }
+            if (wake == ShmWake::CONTROL) {
+                communicator->receive(request, zmq::recv_flags::none);
+                break;
+            }
+            // Clients that send a control request without ringing are still served after the timeout
+            if (communicator->receive(request, zmq::recv_flags::dontwait)) {
+                break;
+            }
+        }
+    } else {
+        communicator->receive(request, zmq::recv_flags::none);
+    }
+    profiler_.record(StepPhase::RECEIVE, t_receive);
+    auto t_parse = StepProfiler::now();
+
+    // Binary action frame, applied without any string parsing
+    if (request.size() >= sizeof(ActionFrameHeader)) {
+        uint32_t magic;
+        memcpy(&magic, request.data(), sizeof(magic));
+        if (magic == ACTION_FRAME_MAGIC) {
+            if (HandleActionFrame(request)) {
+                return "CMD";
+            }
+            communicator->sendJson("CMD ERROR");
+            return "INVALID";
+        }
+    }
 
     std::string cmd = request.to_string();
     // debug output
     // std::cout << "[StonefishRL] Received: (" << result << " bytes) in command: " << cmd << std::endl;
 
-    int pos = cmd.find(":");
+    size_t pos = cmd.find(":");
     std::string prefix = cmd.substr(0, pos);
     cmd = cmd.substr(pos + 1);
 
     if (prefix == "RESET") {
-        // Updated: Use RobotResetInfo instead of InfoObject
-        std::vector<RobotResetInfo> command_data = command_processor_.parseResetCommand(cmd);
-        state_manager_.updateRobotPosition(command_data, this);
-        
-        // Send observations using new vector approach
-        SendObservations();
+        // Logged with the seed actually used, so unseeded resets replay identically
+        double reset_time = getSimulationTime();
+        std::string logged = Reset(pos == std::string::npos ? "" : cmd, [this]() { SendObservations(OBS_FLAG_RESET); });
+        recorder_.writeInput(LogRecordType::RESET, 0, reset_time, logged.data(), logged.size());
         // std::cout << "[StonefishRL] Received RESET command\n";
         return "RESET";
     }
+    else if (prefix == "HELLO") {
+        // Readiness handshake: the reply is only sent once the scene is built and stepping
+        nlohmann::json reply = DescribeLayout();
+        reply["status"] = "READY";
+        communicator->sendJson(reply.dump());
+        std::cout << "[StonefishRL] Client connected (HELLO)" << std::endl;
+        return "HELLO";
+    }
+    else if (prefix == "SNAPSHOT") {
+        // SNAPSHOT:<slot> captures the current world state, reply: SNAPSHOT OK <slot>
+        unsigned int slot;
+        if (ParseSnapshotSlot(pos == std::string::npos ? "" : cmd, slot) && SaveSnapshot(slot)) {
+            recorder_.writeInput(LogRecordType::SNAPSHOT, 0, getSimulationTime(), &slot, sizeof(slot));
+            communicator->sendJson("SNAPSHOT OK " + std::to_string(slot));
+        } else {
+            communicator->sendJson("SNAPSHOT ERROR");
+        }
+        return "SNAPSHOT";
+    }
+    else if (prefix == "RESTORE") {
+        // RESTORE:<slot> is an exact reset, the reply is the observation of the restored state
+        unsigned int slot;
+        if (ParseSnapshotSlot(pos == std::string::npos ? "" : cmd, slot) && RestoreSnapshot(slot)) {
+            recorder_.writeInput(LogRecordType::RESTORE, 0, getSimulationTime(), &slot, sizeof(slot));
+            SendObservations(OBS_FLAG_RESET);
+        } else {
+            communicator->sendJson("RESTORE ERROR");
+        }
+        return "RESTORE";
+    }
     else if (prefix == "EXIT") {
         std::cout << "[StonefishRL] Received EXIT command\n";
         communicator->sendJson("EXIT OK");
         return "EXIT";
     }
+    else if (prefix == "FORMAT") {
+        // Negotiate the observation reply format
+        if (cmd == "BINARY") {
+            observation_format_ = ObservationFormat::BINARY;
+        } else if (cmd == "JSON") {
+            observation_format_ = ObservationFormat::JSON;
+        } else {
+            std::cout << "[StonefishRL] Unknown observation format: " << cmd << std::endl;
+            communicator->sendJson("FORMAT ERROR");
+            return "FORMAT";
+        }
+        std::cout << "[StonefishRL] Observation format set to " << cmd << std::endl;
+        communicator->sendJson("FORMAT OK");
+        return "FORMAT";
+    }
+    else if (prefix == "SHM") {
+        HandleSharedMemoryCommand(cmd);
+        return "SHM";
+    }
+    else if (prefix == "TRAJ") {
+        HandleTrajectoryCommand(pos == std::string::npos ? "" : cmd);
+        return "TRAJ";
+    }
+    else if (prefix == "STATS") {
+        // STATS reports the step phase latencies, STATS:RESET also starts a new measurement window
+        communicator->sendJson(profiler_.report());
+        if (cmd == "RESET") {
+            profiler_.reset();
+        }
+        return "STATS";
+    }
     else if (prefix == "CMD") {
         command_processor_.parseActionCommands(cmd);
+        if (!CheckSubsteps(command_processor_.getSubsteps())) {
+            communicator->sendJson("CMD ERROR");
+            return "INVALID";
+        }
+        if (!state_manager_.selectObservations(command_processor_.getObservationFilter())) {
+            // A filter that selects nothing is a typo, not a request for an empty reply
+            state_manager_.clearObservationFilter();
+            communicator->sendJson("CMD ERROR");
+            return "INVALID";
+        }
+        profiler_.record(StepPhase::PARSE, t_parse);
+        auto t_apply = StepProfiler::now();
         ApplyCommands(cmd);
+        profiler_.record(StepPhase::APPLY, t_apply);
+        pending_substeps_ = command_processor_.getSubsteps();
+        recorder_.writeInput(LogRecordType::COMMAND, getSubsteps(), getSimulationTime(), cmd.data(), cmd.size());
         return "CMD";
     }
     else {
@@ -59,9 +203,96 @@ std::string StonefishRL::RecieveInstructions(sf::SimulationApp& simApp) {
 }
 
 
-void StonefishRL::SendObservations() {
-    // Get observation vector from new StateManager
-    std::vector<float> observations = state_manager_.getObservationVector(this);
+unsigned long long StonefishRL::ServeRequests(sf::SimulationApp& simApp) {
+    std::string instruction;
+    unsigned long long physics_steps = 0;
+    while (instruction != "EXIT") {
+        instruction = RecieveInstructions(simApp);
+
+        // The agent runs at 5-20 Hz while physics runs much faster, so one CMD
+        // holds its action for several physics steps and replies only once
+        if (instruction == "CMD") {
+            unsigned int substeps = getSubsteps();
+            auto step_start = StepProfiler::now();
+            for (unsigned int i = 0; i < substeps; ++i) {
+                simApp.StepSimulation();
+            }
+            profiler_.record(StepPhase::STEP, step_start);
+            profiler_.countStep(substeps);
+            physics_steps += substeps;
+            SendObservations();
+        } else if (instruction == "RESET") {
+            // Reset() already took its physics step
+            ++physics_steps;
+        }
+    }
+    return physics_steps;
+}
+
+void StonefishRL::SendObservations(uint16_t flags) {
+    // Get observation vector from new StateManager (and the reward of the step)
+    auto t_observe = StepProfiler::now();
+    const std::vector<float>& observations = GetObservations(flags);
+    profiler_.record(StepPhase::OBSERVE, t_observe);
+    const StepOutcome* outcome = reward_engine_.isEnabled() ? &reward_engine_.getLastOutcome() : nullptr;
+    // Sampled poses go back with the reply of their reset only
+    std::string reset_info;
+    if ((flags & OBS_FLAG_RESET) && !reset_info_.is_null()) {
+        reset_info = reset_info_.dump();
+    }
+    reset_info_ = nullptr;
+    // Replies to action frames carry the frame's sequence, so pipelined clients can match them
+    reply_sequence_ = action_sequence_ != 0 ? action_sequence_ : reply_sequence_ + 1;
+    action_sequence_ = 0;
+    recorder_.writeObservation(getSimulationTime(), observations.data(), observations.size());
+    if (trajectory_.isOpen()) {
+        // Never blocks, a full ring drops the row
+        uint32_t traj_flags = (flags & OBS_FLAG_RESET) ? TRAJ_FLAG_RESET : 0;
+        if (outcome && (outcome->terminated || outcome->truncated)) {
+            traj_flags |= TRAJ_FLAG_DONE;
+        }
+        trajectory_.record(state_manager_.getUnfilteredObservationVector().data(), actuator_controller_.getLastActions().data(), 
+                           outcome ? outcome->reward : 0.0f, traj_flags, static_cast<double>(getSimulationTime()));
+    }
+
+    auto t_send = StepProfiler::now();
+    if (shm_step_pending_) {
+        shm_step_pending_ = false;
+        shm_transport_.publishObservations(observations.data(), observations.size(), 
+                                           static_cast<double>(getSimulationTime()), reply_sequence_, outcome);
+        profiler_.record(StepPhase::SEND, t_send);
+        return;
+    }
+
+    if (observation_format_ == ObservationFormat::BINARY) {
+        ObservationHeader header;
+        header.magic = OBSERVATION_MAGIC;
+        header.version = OBSERVATION_VERSION;
+        header.flags = flags | (outcome ? OBS_FLAG_OUTCOME : 0) | (reset_info.empty() ? 0 : OBS_FLAG_RESET_INFO);
+        header.sequence = reply_sequence_;
+        header.count = static_cast<uint32_t>(observations.size());
+        header.sim_time = static_cast<double>(getSimulationTime());
+        if (!outcome && reset_info.empty()) {
+            communicator->sendObservationFrame(header, observations.data(), observations.size());
+            profiler_.record(StepPhase::SEND, t_send);
+            return;
+        }
+        // After the observations: [reward, terminated, truncated], then <uint32 length><reset JSON>
+        reply_trailer_.clear();
+        if (outcome) {
+            float values[3] = {outcome->reward, outcome->terminated ? 1.0f : 0.0f, outcome->truncated ? 1.0f : 0.0f};
+            reply_trailer_.append(reinterpret_cast<const char*>(values), sizeof(values));
+        }
+        if (!reset_info.empty()) {
+            uint32_t length = static_cast<uint32_t>(reset_info.size());
+            reply_trailer_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            reply_trailer_.append(reset_info);
+        }
+        communicator->sendObservationFrame(header, observations.data(), observations.size(), 
+                                           reply_trailer_.data(), reply_trailer_.size());
+        profiler_.record(StepPhase::SEND, t_send);
+        return;
+    }
     
     // Convert to JSON array for sending
     std::string obs_json = "[";
@@ -71,7 +302,23 @@ void StonefishRL::SendObservations() {
     }
     obs_json += "]";
     
+    // With a reward config or reset info the array is wrapped together with them
+    if (outcome || !reset_info.empty()) {
+        std::string wrapped = "{\"observation\":" + obs_json;
+        if (outcome) {
+            // nlohmann keeps full precision and writes NaN/inf as null, std::to_string would not
+            wrapped += ",\"reward\":" + nlohmann::json(outcome->reward).dump()
+                     + ",\"terminated\":" + (outcome->terminated ? "true" : "false")
+                     + ",\"truncated\":" + (outcome->truncated ? "true" : "false");
+        }
+        if (!reset_info.empty()) {
+            wrapped += ",\"reset\":" + reset_info;
+        }
+        obs_json = wrapped + "}";
+    }
+    
     communicator->sendJson(obs_json);
+    profiler_.record(StepPhase::SEND, t_send);
     // Debug output
     // std::cout << "[StonefishRL] Sent observation vector: " << observations.size() << " elements" << std::endl;
 }
@@ -83,6 +330,342 @@ void StonefishRL::ApplyCommands(const std::string& str_cmds) {
     // std::cout << "[StonefishRL] Applied commands to " << commands.size() << " actuators" << std::endl;
 }
 
+bool StonefishRL::HandleSharedMemoryCommand(const std::string& cmd) {
+    if (cmd == "OPEN") {
+        std::string name = "stonefish_rl_" + std::to_string(getpid());
+        if (!shm_transport_.open(name, state_manager_.getObservationSize(), actuator_controller_.getActionSize())) {
+            communicator->sendJson("SHM ERROR");
+            return false;
+        }
+        // Reply: SHM OK <segment name> <observation size> <action size>
+        communicator->sendJson("SHM OK " + name + " " + std::to_string(state_manager_.getObservationSize()) 
+                               + " " + std::to_string(actuator_controller_.getActionSize()));
+        return true;
+    }
+    if (cmd == "CLOSE") {
+        shm_transport_.close();
+        communicator->sendJson("SHM OK");
+        return true;
+    }
+    std::cout << "[StonefishRL] Unknown SHM command: " << cmd << std::endl;
+    communicator->sendJson("SHM ERROR");
+    return false;
+}
+
+bool StonefishRL::HandleActionFrame(const zmq::message_t& request) {
+    auto t_parse = StepProfiler::now();
+    ActionFrameHeader header;
+    memcpy(&header, request.data(), sizeof(header));
+    size_t expected = sizeof(header) + static_cast<size_t>(header.count) * sizeof(float);
+
+    if (header.version != OBSERVATION_VERSION || request.size() != expected 
+        || header.count != actuator_controller_.getActionSize()) {
+        std::cerr << "[StonefishRL] Invalid action frame: " << header.count << " values (" << request.size() 
+                  << " bytes), expected " << actuator_controller_.getActionSize() << std::endl;
+        return false;
+    }
+    if (!CheckSubsteps(header.substeps)) {
+        return false;
+    }
+
+    // Small ZMQ messages are stored inline and may not be float aligned
+    action_buffer_.resize(header.count);
+    memcpy(action_buffer_.data(), static_cast<const char*>(request.data()) + sizeof(header), header.count * sizeof(float));
+    profiler_.record(StepPhase::PARSE, t_parse);
+    
+    auto t_apply = StepProfiler::now();
+    actuator_controller_.applyActionVector(action_buffer_.data(), action_buffer_.size());
+    profiler_.record(StepPhase::APPLY, t_apply);
+    pending_substeps_ = header.substeps;
+    
+    if (header.sequence != 0 && last_action_sequence_ != 0 && header.sequence != last_action_sequence_ + 1) {
+        std::cerr << "[StonefishRL] WARNING: Action frame " << header.sequence << " after " << last_action_sequence_ 
+                  << ", frames were skipped or repeated" << std::endl;
+    }
+    action_sequence_ = header.sequence;
+    last_action_sequence_ = header.sequence;
+    recorder_.writeInput(LogRecordType::ACTION, getSubsteps(), getSimulationTime(), 
+                         action_buffer_.data(), action_buffer_.size() * sizeof(float));
+    return true;
+}
+
+unsigned int StonefishRL::getSubsteps() const {
+    return pending_substeps_ > 0 ? pending_substeps_ : action_config_.substeps;
+}
+
+bool StonefishRL::CheckSubsteps(unsigned int requested) const {
+    if (requested > action_config_.max_substeps) {
+        std::cerr << "[StonefishRL] ERROR: " << requested << " substeps requested, max_substeps is " 
+                  << action_config_.max_substeps << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void StonefishRL::ApplyActionVector(const float* values, size_t count) {
+    actuator_controller_.applyActionVector(values, count);
+}
+
+void StonefishRL::StepPhysics(unsigned int steps) {
+    // One SimulationApp per process, so the in-process paths step exactly like the learning loop
+    sf::SimulationApp* app = sf::SimulationApp::getApp();
+    for (unsigned int i = 0; i < steps; ++i) {
+        app->StepSimulation();
+    }
+}
+
+const std::vector<float>& StonefishRL::GetObservations(uint16_t flags) {
+    // A CMD filter only selects the values of its own reply. Trajectory rows and the history need every value
+    bool history = state_manager_.hasHistory();
+    bool filtered = state_manager_.isFiltered();
+    const std::vector<float>* observations = &state_manager_.getObservationVector(this, trajectory_.isOpen() || history);
+    state_manager_.clearObservationFilter();
+    if (history) {
+        // Every step enters the history, filtered replies carry the selection of the current frame only
+        const std::vector<float>& stacked = state_manager_.pushHistory(actuator_controller_.getLastActions(), 
+                                                                       (flags & OBS_FLAG_RESET) != 0);
+        if (!filtered) {
+            observations = &stacked;
+        }
+    }
+    if (reward_engine_.isEnabled()) {
+        reward_engine_.evaluate(actuator_controller_.getLastActions(), (flags & OBS_FLAG_RESET) != 0);
+    }
+    // Contacts and aggregates are reported per reply, the next interval starts now
+    state_manager_.resetCollisions();
+    state_manager_.resetAggregates();
+    return *observations;
+}
+
+std::string StonefishRL::ResetRobots(const std::string& reset_payload) {
+    // With a reset config, an empty payload or a bare seed samples the poses in C++
+    size_t end = reset_payload.find_last_not_of(" \t\r\n;");
+    std::string payload = end == std::string::npos ? "" : reset_payload.substr(0, end + 1);
+    bool is_seed = !payload.empty() && payload.find_first_not_of("0123456789") == std::string::npos;
+    control_pipeline_.reset();
+    
+    if (!reset_sampler_.isEnabled() || (!payload.empty() && !is_seed)) {
+        reset_info_ = nullptr;
+        state_manager_.updateRobotPosition(command_processor_.parseResetCommand(reset_payload), this);
+        return reset_payload;
+    }
+    
+    uint64_t seed;
+    if (!is_seed || !ResetSampler::parseSeed(payload, seed)) {
+        if (is_seed) {
+            std::cerr << "[StonefishRL] ERROR: Reset seed " << payload << " does not fit in 64 bits, using the next seed" << std::endl;
+        }
+        seed = reset_sampler_.nextSeed();
+    }
+    state_manager_.updateRobotPosition(reset_sampler_.sample(seed), this);
+    reset_info_ = reset_sampler_.getLastSample();
+    return std::to_string(seed);
+}
+
+std::string StonefishRL::Reset(const std::string& reset_payload, const std::function<void()>& observe) {
+    // The observation is taken before the step, so the reply shows the poses exactly as respawned
+    std::string logged = ResetRobots(reset_payload);
+    observe();
+    StepPhysics(1);
+    // The settle step belongs to no reply, the first interval covers only the first action's substeps
+    state_manager_.resetCollisions();
+    state_manager_.resetAggregates();
+    return logged;
+}
+
+nlohmann::json StonefishRL::DescribeLayout() const {
+    nlohmann::json layout;
+    layout["version"] = OBSERVATION_VERSION;
+    layout["observation_size"] = state_manager_.getObservationSize();
+    layout["action_size"] = actuator_controller_.getActionSize();
+    layout["substeps"] = action_config_.substeps;
+    layout["max_substeps"] = action_config_.max_substeps;
+    layout["frequency"] = frequency_;
+    layout["async"] = async_mode_;
+    layout["reward"] = reward_engine_.isEnabled();
+    layout["reset_sampling"] = reset_sampler_.isEnabled();
+    layout["observations"] = state_manager_.getObservationNames();
+    layout["history"] = state_manager_.hasHistory();
+    std::vector<std::string> actions;
+    for (const auto& spec : action_config_.specs) {
+        actions.push_back(spec.output_name);
+    }
+    layout["actions"] = actions;
+    layout["controllers"] = control_pipeline_.getControllerNames();
+    return layout;
+}
+
+bool StonefishRL::StartRecording(const std::string& path) {
+    return recorder_.open(path, static_cast<uint32_t>(state_manager_.getObservationSize()), 
+                          static_cast<uint32_t>(action_config_.specs.size()), frequency_);
+}
+
+int StonefishRL::ReplayLog(sf::SimulationApp& simApp, const std::string& path, bool verify) {
+    EpisodeLogReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    const EpisodeLogHeader& header = reader.getHeader();
+    if (header.observation_size != state_manager_.getObservationSize() || header.action_size != action_config_.specs.size()) {
+        std::cerr << "[StonefishRL] ERROR: Log layout (" << header.observation_size << " observations, " << header.action_size 
+                  << " actions) does not match the configs" << std::endl;
+        return 1;
+    }
+    if (header.frequency != frequency_) {
+        std::cout << "[StonefishRL] WARNING: Log recorded at " << header.frequency << " Hz, replaying at " 
+                  << frequency_ << " Hz" << std::endl;
+    }
+
+    LogRecordHeader record;
+    std::vector<char> payload;
+    std::vector<float> last_observation;
+    unsigned long long inputs = 0, physics_steps = 0, checked = 0, mismatches = 0;
+    auto start = StepProfiler::now();
+
+    // Same order as the learning loop: apply input, step, observe (Reset() observes before its step)
+    auto step = [&](unsigned int steps) {
+        for (unsigned int i = 0; i < steps; ++i) {
+            simApp.StepSimulation();
+        }
+        physics_steps += steps;
+    };
+    auto observe = [&](uint16_t flags) {
+        const std::vector<float>& obs = GetObservations(flags);
+        last_observation.assign(obs.begin(), obs.end());
+    };
+
+    while (reader.next(record, payload)) {
+        switch (static_cast<LogRecordType>(record.type)) {
+        case LogRecordType::RESET:
+            Reset(std::string(payload.begin(), payload.end()), [&]() { observe(OBS_FLAG_RESET); });
+            ++physics_steps;
+            break;
+        case LogRecordType::COMMAND: {
+            std::string cmd(payload.begin(), payload.end());
+            command_processor_.parseActionCommands(cmd);
+            state_manager_.selectObservations(command_processor_.getObservationFilter());
+            ApplyCommands(cmd);
+            step(record.substeps);
+            observe(0);
+            break;
+        }
+        case LogRecordType::ACTION:
+            actuator_controller_.applyActionVector(reinterpret_cast<const float*>(payload.data()), payload.size() / sizeof(float));
+            step(record.substeps);
+            observe(0);
+            break;
+        case LogRecordType::SNAPSHOT:
+        case LogRecordType::RESTORE: {
+            uint32_t slot = 0;
+            memcpy(&slot, payload.data(), std::min(payload.size(), sizeof(slot)));
+            if (static_cast<LogRecordType>(record.type) == LogRecordType::SNAPSHOT) {
+                SaveSnapshot(slot);
+            } else {
+                RestoreSnapshot(slot);
+                observe(OBS_FLAG_RESET);
+            }
+            break;
+        }
+        case LogRecordType::OBSERVATION:
+            if (verify) {
+                ++checked;
+                if (payload.size() != last_observation.size() * sizeof(float) 
+                    || memcmp(payload.data(), last_observation.data(), payload.size()) != 0) {
+                    if (mismatches == 0) {
+                        std::cerr << "[StonefishRL] Replay diverged at input " << record.sequence 
+                                  << " (t = " << record.sim_time << " s)" << std::endl;
+                    }
+                    ++mismatches;
+                }
+            }
+            continue;
+        default:
+            std::cerr << "[StonefishRL] WARNING: Unknown log record type " << record.type << std::endl;
+            continue;
+        }
+        ++inputs;
+    }
+
+    double elapsed = std::chrono::duration<double>(StepProfiler::now() - start).count();
+    std::cout << "[StonefishRL] Replayed " << inputs << " inputs, " << physics_steps << " physics steps in " 
+              << elapsed << " s (" << (elapsed > 0.0 ? physics_steps / elapsed : 0.0) << " steps/s)" << std::endl;
+    if (verify) {
+        std::cout << "[StonefishRL] Verification: " << checked - mismatches << "/" << checked 
+                  << " observations identical" << std::endl;
+        return mismatches == 0 ? 0 : 2;
+    }
+    return 0;
+}
+
+bool StonefishRL::StartTrajectory(const std::string& directory) {
+    std::vector<std::string> actions;
+    for (const auto& spec : action_config_.specs) {
+        actions.push_back(spec.output_name);
+    }
+    return trajectory_.open(directory, state_manager_.getObservationNames(false), actions);
+}
+
+void StonefishRL::HandleTrajectoryCommand(const std::string& cmd) {
+    // TRAJ:START:<directory>, TRAJ:STOP, TRAJ (status). Every reply is the recorder status
+    if (cmd.compare(0, 6, "START:") == 0) {
+        if (!StartTrajectory(cmd.substr(6))) {
+            communicator->sendJson("TRAJ ERROR");
+            return;
+        }
+    } else if (cmd == "STOP") {
+        StopTrajectory();
+    } else if (!cmd.empty()) {
+        std::cout << "[StonefishRL] Unknown TRAJ command: " << cmd << std::endl;
+        communicator->sendJson("TRAJ ERROR");
+        return;
+    }
+
+    nlohmann::json status;
+    status["recording"] = trajectory_.isOpen();
+    status["directory"] = trajectory_.getDirectory();
+    status["rows"] = trajectory_.getAcceptedCount();
+    status["written"] = trajectory_.getRecordedCount();
+    status["dropped"] = trajectory_.getDroppedCount();
+    communicator->sendJson(status.dump());
+}
+
+bool StonefishRL::ParseSnapshotSlot(const std::string& arg, unsigned int& slot) const {
+    if (arg.empty()) {
+        slot = 0;
+        return true;
+    }
+    char* end = nullptr;
+    unsigned long value = std::strtoul(arg.c_str(), &end, 10);
+    if (end == arg.c_str() || *end != '\0' || value >= MAX_SNAPSHOT_SLOTS) {
+        std::cerr << "[StonefishRL] Invalid snapshot slot: " << arg << " (0-" << MAX_SNAPSHOT_SLOTS - 1 << ")" << std::endl;
+        return false;
+    }
+    slot = static_cast<unsigned int>(value);
+    return true;
+}
+
+bool StonefishRL::SaveSnapshot(unsigned int slot) {
+    if (slot >= MAX_SNAPSHOT_SLOTS) return false;
+    if (slot >= snapshots_.size()) {
+        snapshots_.resize(slot + 1);
+    }
+    snapshots_[slot].capture(this);
+    return true;
+}
+
+bool StonefishRL::RestoreSnapshot(unsigned int slot) {
+    if (slot >= snapshots_.size() || !snapshots_[slot].isValid()) {
+        std::cerr << "[StonefishRL] Snapshot slot " << slot << " is empty" << std::endl;
+        return false;
+    }
+    snapshots_[slot].restore(this);
+    state_manager_.resetCollisions();
+    state_manager_.resetAggregates();
+    state_manager_.invalidateSensorCache();
+    control_pipeline_.reset();
+    return true;
+}
+
 void StonefishRL::BuildScenario() {
     std::cout << "[StonefishRL] Building scenario from: " << scenePath << std::endl;
     sf::ScenarioParser parser(this);
@@ -119,7 +702,15 @@ void StonefishRL::BuildScenario() {
         robotNames.push_back(robot_ptr->getName());
     }
 
-    // Force StateManager to rebuild cache
+    // Resolve the observation specs and action specs against the new scenario
+    state_manager_.compileObservationPlan(this);
+    control_pipeline_.compile(this);
+    actuator_controller_.bindActionSpecs(action_config_, this, &control_pipeline_);
+    reward_engine_.compile(this, state_manager_);
+    
+    // Initial state of the scene, RESTORE:0 goes back to it without reloading
+    snapshots_.clear();
+    SaveSnapshot(0);
 
     std::cout << "[StonefishRL] Scenario loaded successfully. Found: " 
               << robotNames.size() << " robots, "
@@ -128,77 +719,20 @@ void StonefishRL::BuildScenario() {
 }
 
 
-std::vector<std::string> StonefishRL::RobotCollisionDetector(std::string& collision_robot)
-{
-    sf::Entity* entA;
-    sf::Entity* entB; 
-    std::vector<std::string> collision_list;
-    int i=0;
-    if  (collision_robot.find("girona") == std::string::npos) {
-        return collision_list; // only check collisions for the girona robot
-    }
-    // std::cout << "Checking for collisions..." << std::endl;
-
-    btDispatcher* dispatcher = getDynamicsWorld()->getDispatcher();
-    int numManifolds = dispatcher->getNumManifolds();
-
-    for(int i=0; i<numManifolds; ++i)
-        {
-            btPersistentManifold* contactManifold = dispatcher->getManifoldByIndexInternal(i);
-            if(contactManifold->getNumContacts() == 0)
-                continue;
-
-            btCollisionObject* coA = (btCollisionObject*)contactManifold->getBody0();
-            btCollisionObject* coB = (btCollisionObject*)contactManifold->getBody1();
-            entA = (sf::Entity*)coA->getUserPointer();
-            entB = (sf::Entity*)coB->getUserPointer();
-        
-            if (CheckNameForCollision(entA->getName(), entB->getName(), collision_robot))
-            {   
-                std::string collision_info = entA->getName() +"AND"+ entB->getName();
-                collision_list.push_back(collision_info);
-            }
-        };
-
-        // std::cout << "Collisions detected with: ";
-        // for (const auto& name : collision_list)
-        // {
-        //     std::cout << name << " ";
-        // }
-        // std::cout << collision_list.size() << std::endl;
-
-    return collision_list;
-}
-
-
-bool StonefishRL::CheckNameForCollision(std::string name, std::string name2, std::string& collision_robot)
-{
-    std::string obj1, obj2;
-    std::vector<std::string> collision_target = {"Tank"}; // we will add the parts of the docking station later     
-    // Extract robot names from both input strings
-    
-    if (name.find(collision_robot) != std::string::npos) {
-        obj1 = name;
-        // std::cout << "Collision with target detected: " << name << std::endl;
-    }
-
-    for (const auto& part : collision_target)
-    {
-        
-        if (name2.find(part) != std::string::npos) {
-                obj2 = name2;
-                // std::cout << "Collision with target detected: " << name2 << std::endl;
-
-            }
-    }
-    // check if the robot is coliding with the tank
-    // Check if we found two DIFFERENT robots
-    return (!obj1.empty() && !obj2.empty() && obj1 != obj2);
+void StonefishRL::SimulationStepCompleted(sf::Scalar timeStep) {
+    // Contact manifolds are walked once per physics step, including every substep of a CMD
+    state_manager_.updateCollisions(this);
+    state_manager_.updateAggregates(this, static_cast<float>(timeStep));
+    // Low-level controllers track the latest agent setpoints at the physics rate
+    control_pipeline_.update(static_cast<float>(timeStep));
 }
 
 void StonefishRL::ExitRequest() {
     // socket.close();
     // context.close();
+    shm_transport_.close();
+    recorder_.close();
+    trajectory_.close();
     delete communicator;
 
     std::cout << "[INFO] Simulation finished." << std::endl;
@@ -0,0 +1,34 @@
+#include "SubstepAccumulators.h"
+#include <algorithm>
+#include <limits>
+
+void SubstepAccumulators::resize(size_t count) {
+    sum_.assign(count, 0.0f);
+    integral_.assign(count, 0.0f);
+    min_.assign(count, 0.0f);
+    max_.assign(count, 0.0f);
+    reset();
+}
+
+void SubstepAccumulators::add(const float* values, float dt) {
+    size_t n = sum_.size();
+    float* sum = sum_.data();
+    float* integral = integral_.data();
+    float* min = min_.data();
+    float* max = max_.data();
+    for (size_t k = 0; k < n; ++k) {
+        sum[k] += values[k];
+        integral[k] += values[k] * dt;
+        min[k] = std::min(min[k], values[k]);
+        max[k] = std::max(max[k], values[k]);
+    }
+    ++steps_;
+}
+
+void SubstepAccumulators::reset() {
+    std::fill(sum_.begin(), sum_.end(), 0.0f);
+    std::fill(integral_.begin(), integral_.end(), 0.0f);
+    std::fill(min_.begin(), min_.end(), std::numeric_limits<float>::max());
+    std::fill(max_.begin(), max_.end(), std::numeric_limits<float>::lowest());
+    steps_ = 0;
+}
@@ -0,0 +1,197 @@
+#include "TrajectoryRecorder.h"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <sys/stat.h>
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    close();
+}
+
+bool TrajectoryRecorder::open(const std::string& directory, const std::vector<std::string>& observation_names,
+                              const std::vector<std::string>& action_names, size_t ring_rows, size_t chunk_rows) {
+    close();
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[TrajectoryRecorder] ERROR: Cannot create directory " << directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    directory_ = directory;
+    observation_names_ = observation_names;
+    action_names_ = action_names;
+    obs_size_ = observation_names.size();
+    action_size_ = action_names.size();
+    chunk_rows_ = chunk_rows > 0 ? chunk_rows : 4096;
+    chunk_fill_ = 0;
+
+    columns_.clear();
+    columns_.push_back({"sim_time", "<f8", 1, sizeof(double)});
+    columns_.push_back({"step", "<u4", 1, sizeof(uint32_t)});
+    columns_.push_back({"flags", "<u4", 1, sizeof(uint32_t)});
+    columns_.push_back({"reward", "<f4", 1, sizeof(float)});
+    columns_.push_back({"observation", "<f4", obs_size_, sizeof(float)});
+    columns_.push_back({"action", "<f4", action_size_, sizeof(float)});
+    for (auto& column : columns_) {
+        std::string path = directory_ + "/" + column.name + ".bin";
+        column.file = std::fopen(path.c_str(), "wb");
+        if (!column.file) {
+            std::cerr << "[TrajectoryRecorder] ERROR: Cannot create " << path << std::endl;
+            for (auto& c : columns_) {
+                if (c.file) std::fclose(c.file);
+            }
+            columns_.clear();
+            return false;
+        }
+        column.chunk.resize(chunk_rows_ * column.width * column.value_size);
+    }
+
+    // Power of two ring, a slot holds one row
+    size_t capacity = 1;
+    while (capacity < ring_rows) capacity <<= 1;
+    slot_size_ = (sizeof(RowHeader) + (obs_size_ + action_size_) * sizeof(float) + 7) & ~size_t(7);
+    ring_.assign(capacity * slot_size_, 0);
+    ring_mask_ = capacity - 1;
+    head_.store(0);
+    tail_.store(0);
+    dropped_.store(0);
+    written_.store(0);
+    episode_step_ = UINT32_MAX;
+    staged_ = false;
+    accepted_ = 0;
+
+    writeIndex();
+    running_.store(true, std::memory_order_release);
+    writer_ = std::thread(&TrajectoryRecorder::writerLoop, this);
+    std::cout << "[TrajectoryRecorder] Recording to " << directory_ << " (ring of " << capacity << " rows)" << std::endl;
+    return true;
+}
+
+void TrajectoryRecorder::close() {
+    if (!writer_.joinable()) return;
+    if (staged_) {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        staged_ = false;
+    }
+    running_.store(false, std::memory_order_release);
+    writer_.join();
+    for (auto& column : columns_) {
+        std::fclose(column.file);
+        column.file = nullptr;
+    }
+    std::cout << "[TrajectoryRecorder] Wrote " << getRecordedCount() << " rows to " << directory_ 
+              << ", dropped " << getDroppedCount() << std::endl;
+}
+
+bool TrajectoryRecorder::record(const float* observation, const float* action, float reward, uint32_t flags, double sim_time) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (staged_) {
+        // A new episode ends the previous one, also when no reward config reports it
+        if (flags & TRAJ_FLAG_RESET) {
+            RowHeader* previous = reinterpret_cast<RowHeader*>(&ring_[(head & ring_mask_) * slot_size_]);
+            previous->flags |= TRAJ_FLAG_DONE;
+        }
+        head_.store(++head, std::memory_order_release);
+        staged_ = false;
+    }
+    if (head - tail_.load(std::memory_order_acquire) > ring_mask_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    episode_step_ = (flags & TRAJ_FLAG_RESET) ? 0 : episode_step_ + 1;
+    char* slot = &ring_[(head & ring_mask_) * slot_size_];
+    RowHeader row{sim_time, episode_step_, flags, reward, 0};
+    std::memcpy(slot, &row, sizeof(row));
+    float* values = reinterpret_cast<float*>(slot + sizeof(RowHeader));
+    std::memcpy(values, observation, obs_size_ * sizeof(float));
+    if (action) {
+        std::memcpy(values + obs_size_, action, action_size_ * sizeof(float));
+    } else {
+        std::memset(values + obs_size_, 0, action_size_ * sizeof(float));
+    }
+    // Published by the next row (or close()), once it is known whether this one ends the episode
+    staged_ = true;
+    ++accepted_;
+    return true;
+}
+
+void TrajectoryRecorder::writerLoop() {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        size_t head = head_.load(std::memory_order_acquire);
+        if (tail == head) {
+            if (!running_.load(std::memory_order_acquire)) {
+                // Rows pushed before close() was called are still written
+                if (head_.load(std::memory_order_acquire) == tail) break;
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        for (; tail != head; ++tail) {
+            appendRow(&ring_[(tail & ring_mask_) * slot_size_]);
+            tail_.store(tail + 1, std::memory_order_release);
+        }
+    }
+    flushChunk();
+    writeIndex();
+}
+
+void TrajectoryRecorder::appendRow(const char* slot) {
+    RowHeader row;
+    std::memcpy(&row, slot, sizeof(row));
+    const char* values = slot + sizeof(RowHeader);
+    const void* sources[] = {&row.sim_time, &row.step, &row.flags, &row.reward, 
+                             values, values + obs_size_ * sizeof(float)};
+
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        Column& column = columns_[c];
+        size_t row_bytes = column.width * column.value_size;
+        std::memcpy(column.chunk.data() + chunk_fill_ * row_bytes, sources[c], row_bytes);
+    }
+    if (++chunk_fill_ == chunk_rows_) {
+        flushChunk();
+    }
+}
+
+void TrajectoryRecorder::flushChunk() {
+    if (chunk_fill_ == 0) return;
+    for (auto& column : columns_) {
+        std::fwrite(column.chunk.data(), column.width * column.value_size, chunk_fill_, column.file);
+        std::fflush(column.file);
+    }
+    written_.fetch_add(chunk_fill_, std::memory_order_relaxed);
+    chunk_fill_ = 0;
+    // The index only counts rows that are already in the column files
+    writeIndex();
+}
+
+void TrajectoryRecorder::writeIndex() {
+    nlohmann::json index;
+    index["format"] = "stonefish_rl_trajectory";
+    index["version"] = 1;
+    index["num_rows"] = getRecordedCount();
+    index["dropped"] = getDroppedCount();
+    index["chunk_rows"] = chunk_rows_;
+    index["observation_names"] = observation_names_;
+    index["action_names"] = action_names_;
+    index["columns"] = nlohmann::json::array();
+    for (const auto& column : columns_) {
+        nlohmann::json shape = nlohmann::json::array();
+        if (column.name == "observation" || column.name == "action") {
+            shape.push_back(column.width);
+        }
+        index["columns"].push_back({{"name", column.name}, {"file", column.name + ".bin"}, 
+                                    {"dtype", column.dtype}, {"shape", shape}});
+    }
+
+    std::string path = directory_ + "/index.json";
+    {
+        std::ofstream out(path + ".tmp");
+        out << index.dump(2) << std::endl;
+    }
+    std::rename((path + ".tmp").c_str(), path.c_str());
+}
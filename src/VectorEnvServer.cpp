@@ -0,0 +1,391 @@
+#include "VectorEnvServer.h"
+#include "ResetSampler.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+// Snapshot slot as in SNAPSHOT/RESTORE, empty is slot 0
+bool parseSlot(const std::string& arg, unsigned int& slot) {
+    char* end = nullptr;
+    unsigned long value = arg.empty() ? 0 : std::strtoul(arg.c_str(), &end, 10);
+    if ((!arg.empty() && *end != '\0') || value >= MAX_SNAPSHOT_SLOTS) {
+        std::cerr << "[VectorEnvServer] Invalid snapshot slot: " << arg << " (0-" << MAX_SNAPSHOT_SLOTS - 1 << ")" << std::endl;
+        return false;
+    }
+    slot = static_cast<unsigned int>(value);
+    return true;
+}
+
+}  // namespace
+
+VectorEnvServer::VectorEnvServer(const std::vector<std::string>& worker_endpoints, const std::string& address, int ready_timeout_ms)
+    : context_(1),
+      communicator_(address)
+{
+    ready_ = connectWorkers(worker_endpoints, ready_timeout_ms);
+    if (!ready_) return;
+
+    observations_.assign(workers_.size() * obs_size_, 0.0f);
+    outcomes_.assign(workers_.size() * 3, 0.0f);
+    reset_info_.assign(workers_.size(), std::string());
+    snapshot_slots_.assign(workers_.size(), 1u);  // slot 0 is captured by every worker after its scene is built
+    frame_.resize(sizeof(ActionFrameHeader) + action_size_ * sizeof(float));
+    std::cout << "[VectorEnvServer] " << workers_.size() << " environments (one process each), " << obs_size_
+              << " observations, " << action_size_ << " actions each" << std::endl;
+}
+
+bool VectorEnvServer::connectWorkers(const std::vector<std::string>& worker_endpoints, int ready_timeout_ms) {
+    for (const std::string& endpoint : worker_endpoints) {
+        workers_.emplace_back(context_, zmq::socket_type::req);
+        workers_.back().set(zmq::sockopt::linger, 0);
+        workers_.back().connect(endpoint);
+    }
+
+    // HELLO to every worker at once, each one replies when its scene is built
+    for (auto& worker : workers_) {
+        worker.send(zmq::str_buffer("HELLO"), zmq::send_flags::none);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ready_timeout_ms);
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        zmq::pollitem_t item = {static_cast<void*>(workers_[i]), 0, ZMQ_POLLIN, 0};
+        zmq::message_t reply;
+        if (zmq::poll(&item, 1, std::max(remaining, std::chrono::milliseconds(0))) <= 0
+            || !workers_[i].recv(reply, zmq::recv_flags::none)) {
+            std::cerr << "[VectorEnvServer] ERROR: Environment " << i << " (" << worker_endpoints[i]
+                      << ") did not answer HELLO" << std::endl;
+            return false;
+        }
+        nlohmann::json layout = nlohmann::json::parse(reply.to_string(), nullptr, false);
+        if (layout.is_discarded() || layout.value("status", "") != "READY") {
+            std::cerr << "[VectorEnvServer] ERROR: Unexpected HELLO reply from environment " << i << std::endl;
+            return false;
+        }
+        if (i == 0) {
+            layout_ = layout;
+        } else if (layout["observation_size"] != layout_["observation_size"] || layout["action_size"] != layout_["action_size"]) {
+            std::cerr << "[VectorEnvServer] ERROR: Environment " << i << " has a different layout" << std::endl;
+            return false;
+        }
+    }
+    if (workers_.empty()) return false;
+    obs_size_ = layout_.value("observation_size", 0u);
+    action_size_ = layout_.value("action_size", 0u);
+    max_substeps_ = layout_.value("max_substeps", 0u);
+    outcome_ = layout_.value("reward", false);
+
+    // Batches are gathered as binary observation replies
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        zmq::message_t reply;
+        workers_[i].send(zmq::str_buffer("FORMAT:BINARY"), zmq::send_flags::none);
+        if (!workers_[i].recv(reply, zmq::recv_flags::none) || reply.to_string() != "FORMAT OK") {
+            std::cerr << "[VectorEnvServer] ERROR: Environment " << i << " rejected the binary format" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void VectorEnvServer::Run() {
+    while (true) {
+        zmq::message_t request;
+        if (!communicator_.receive(request, zmq::recv_flags::none)) {
+            continue;
+        }
+
+        // Binary batched step
+        if (request.size() >= sizeof(BatchStepHeader)) {
+            uint32_t magic;
+            std::memcpy(&magic, request.data(), sizeof(magic));
+            if (magic == BATCH_STEP_MAGIC) {
+                if (handleStep(request)) {
+                    sendBatch(0);
+                } else {
+                    communicator_.sendJson("VSTEP ERROR");
+                }
+                continue;
+            }
+        }
+
+        // Text control commands
+        std::string cmd = request.to_string();
+        size_t pos = cmd.find(":");
+        std::string prefix = cmd.substr(0, pos);
+        std::string args = pos == std::string::npos ? "" : cmd.substr(pos + 1);
+
+        if (prefix == "HELLO") {
+            nlohmann::json reply = layout_;
+            reply["status"] = "READY";
+            reply["num_envs"] = workers_.size();
+            communicator_.sendJson(reply.dump());
+        }
+        else if (prefix == "VINFO") {
+            // Reply: VINFO <num_envs> <observation size> <action size>
+            communicator_.sendJson("VINFO " + std::to_string(workers_.size()) + " " + std::to_string(obs_size_)
+                                   + " " + std::to_string(action_size_));
+        }
+        else if (prefix == "VRESET") {
+            if (handleReset(args)) {
+                sendBatch(OBS_FLAG_RESET);
+            } else {
+                communicator_.sendJson("VRESET ERROR");
+            }
+        }
+        else if (prefix == "VSNAPSHOT") {
+            if (handleSnapshot(args)) {
+                communicator_.sendJson("VSNAPSHOT OK");
+            } else {
+                communicator_.sendJson("VSNAPSHOT ERROR");
+            }
+        }
+        else if (prefix == "VRESTORE") {
+            if (handleRestore(args)) {
+                sendBatch(OBS_FLAG_RESET);
+            } else {
+                communicator_.sendJson("VRESTORE ERROR");
+            }
+        }
+        else if (prefix == "EXIT") {
+            std::cout << "[VectorEnvServer] Received EXIT command" << std::endl;
+            exchange(std::vector<bool>(workers_.size(), true), [](size_t) { return zmq::str_buffer("EXIT"); },
+                     [](size_t, const zmq::message_t&) { return true; });
+            communicator_.sendJson("EXIT OK");
+            return;
+        }
+        else {
+            std::cout << "[VectorEnvServer] Unknown command prefix: " << prefix << std::endl;
+            communicator_.sendJson("INVALID");
+        }
+    }
+}
+
+bool VectorEnvServer::exchange(const std::vector<bool>& selected, const std::function<zmq::const_buffer(size_t)>& request,
+                               const ReplyHandler& handle_reply) {
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        if (selected[i]) {
+            workers_[i].send(request(i), zmq::send_flags::none);
+        }
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        if (!selected[i]) continue;
+        zmq::message_t reply;
+        if (!workers_[i].recv(reply, zmq::recv_flags::none)) {
+            std::cerr << "[VectorEnvServer] ERROR: No reply from environment " << i << std::endl;
+            ok = false;
+            continue;
+        }
+        if (!(handle_reply ? handle_reply(i, reply) : readObservation(i, reply))) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool VectorEnvServer::readObservation(size_t index, const zmq::message_t& reply) {
+    ObservationHeader header;
+    if (reply.size() < sizeof(header)) {
+        std::cerr << "[VectorEnvServer] ERROR: Environment " << index << " replied " << reply.to_string() << std::endl;
+        return false;
+    }
+    std::memcpy(&header, reply.data(), sizeof(header));
+    const char* values = static_cast<const char*>(reply.data()) + sizeof(header);
+    size_t payload = static_cast<size_t>(header.count) * sizeof(float);
+    if (header.magic != OBSERVATION_MAGIC || header.count != obs_size_ || reply.size() < sizeof(header) + payload) {
+        std::cerr << "[VectorEnvServer] ERROR: Invalid observation reply from environment " << index << std::endl;
+        return false;
+    }
+    std::memcpy(&observations_[index * obs_size_], values, payload);
+    if (index == 0) {
+        sim_time_ = header.sim_time;
+    }
+    size_t offset = sizeof(header) + payload;
+    if (header.flags & OBS_FLAG_OUTCOME) {
+        if (reply.size() < offset + 3 * sizeof(float)) return false;
+        std::memcpy(&outcomes_[index * 3], values + payload, 3 * sizeof(float));
+        offset += 3 * sizeof(float);
+    }
+    reset_info_[index].clear();
+    if (header.flags & OBS_FLAG_RESET_INFO) {
+        uint32_t length = 0;
+        if (reply.size() < offset + sizeof(length)) return false;
+        std::memcpy(&length, static_cast<const char*>(reply.data()) + offset, sizeof(length));
+        if (reply.size() < offset + sizeof(length) + length) return false;
+        reset_info_[index].assign(static_cast<const char*>(reply.data()) + offset + sizeof(length), length);
+    }
+    return true;
+}
+
+bool VectorEnvServer::parseTargets(const std::string& target, std::vector<bool>& selected) const {
+    // "*" or a comma separated list of environment indices ("0,3,5")
+    selected.assign(workers_.size(), target == "*");
+    if (target == "*") return true;
+    size_t begin = 0;
+    while (begin <= target.size()) {
+        size_t comma = std::min(target.find(',', begin), target.size());
+        std::string item = target.substr(begin, comma - begin);
+        char* end = nullptr;
+        unsigned long index = std::strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || index >= workers_.size()) {
+            std::cerr << "[VectorEnvServer] Invalid environment index: " << item << std::endl;
+            return false;
+        }
+        selected[index] = true;
+        begin = comma + 1;
+    }
+    return true;
+}
+
+bool VectorEnvServer::handleStep(const zmq::message_t& msg) {
+    BatchStepHeader header;
+    std::memcpy(&header, msg.data(), sizeof(header));
+    size_t expected = sizeof(header) + workers_.size() * action_size_ * sizeof(float);
+
+    if (header.num_envs != workers_.size() || header.action_size != action_size_ || msg.size() != expected) {
+        std::cerr << "[VectorEnvServer] ERROR: Batch step of " << header.num_envs << "x" << header.action_size
+                  << " (" << msg.size() << " bytes), expected " << workers_.size() << "x" << action_size_ << std::endl;
+        return false;
+    }
+    // Checked here too, so an oversized batch is refused before any environment steps
+    if (header.substeps > max_substeps_) {
+        std::cerr << "[VectorEnvServer] ERROR: " << header.substeps << " substeps requested, max_substeps is " 
+                  << max_substeps_ << std::endl;
+        return false;
+    }
+
+    ActionFrameHeader frame;
+    frame.magic = ACTION_FRAME_MAGIC;
+    frame.version = OBSERVATION_VERSION;
+    frame.substeps = header.substeps;
+    frame.count = static_cast<uint32_t>(action_size_);
+    frame.sequence = 0;     // no ordering check, every worker gets one frame per batch
+    std::memcpy(frame_.data(), &frame, sizeof(frame));
+
+    // Row i of the action matrix goes to worker i (the send copies the frame)
+    const char* actions = static_cast<const char*>(msg.data()) + sizeof(header);
+    const size_t row = action_size_ * sizeof(float);
+    return exchange(std::vector<bool>(workers_.size(), true), [&](size_t i) {
+        std::memcpy(frame_.data() + sizeof(ActionFrameHeader), actions + i * row, row);
+        return zmq::buffer(frame_);
+    });
+}
+
+bool VectorEnvServer::handleReset(const std::string& args) {
+    // VRESET:<* or env indices>:<reset payload>. The payload is sent to every selected environment,
+    // except {"envs": [...]} which holds one payload per environment (poses, seed or null)
+    size_t pos = args.find(":");
+    std::string target = args.substr(0, pos);
+    std::string payload = pos == std::string::npos ? "" : args.substr(pos + 1);
+    std::vector<bool> selected;
+    if (!parseTargets(target, selected)) return false;
+
+    std::vector<std::string> payloads(workers_.size(), payload);
+    nlohmann::json per_env = nlohmann::json::parse(payload, nullptr, false);
+    if (per_env.is_object() && per_env.contains("envs")) {
+        const nlohmann::json& envs = per_env["envs"];
+        if (!envs.is_array() || envs.size() != workers_.size()) {
+            std::cerr << "[VectorEnvServer] ERROR: VRESET needs one payload per environment (" << workers_.size() << ")" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            payloads[i] = envs[i].is_null() ? "" : envs[i].dump();
+        }
+    } else {
+        // One seed for every environment ("*") is mixed with the env index, so they do not all start alike
+        bool is_seed = !payload.empty() && payload.find_first_not_of("0123456789") == std::string::npos;
+        uint64_t seed = 0;
+        if (is_seed && !ResetSampler::parseSeed(payload, seed)) {
+            std::cerr << "[VectorEnvServer] ERROR: Reset seed " << payload << " does not fit in 64 bits" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < workers_.size() && is_seed && target == "*"; ++i) {
+            payloads[i] = std::to_string(ResetSampler::environmentSeed(seed, i));
+        }
+    }
+
+    std::vector<std::string> requests(workers_.size());
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        requests[i] = "RESET:" + payloads[i];
+    }
+    return exchange(selected, [&](size_t i) { return zmq::buffer(requests[i]); });
+}
+
+bool VectorEnvServer::handleSnapshot(const std::string& args) {
+    // VSNAPSHOT:<* or env indices>:<snapshot slot>
+    size_t pos = args.find(":");
+    std::vector<bool> selected;
+    unsigned int slot;
+    if (!parseTargets(args.substr(0, pos), selected) || !parseSlot(pos == std::string::npos ? "" : args.substr(pos + 1), slot)) {
+        return false;
+    }
+    // Only the workers that answer SNAPSHOT OK have the slot, so a later VRESTORE is checked against them
+    std::string request = "SNAPSHOT:" + std::to_string(slot);
+    return exchange(selected, [&](size_t) { return zmq::buffer(request); }, [&](size_t i, const zmq::message_t& reply) {
+        std::string answer = reply.to_string();
+        if (answer.rfind("SNAPSHOT OK", 0) != 0) {
+            std::cerr << "[VectorEnvServer] ERROR: Environment " << i << " replied " << answer 
+                      << " to snapshot slot " << slot << std::endl;
+            return false;
+        }
+        snapshot_slots_[i] |= 1u << slot;
+        return true;
+    });
+}
+
+bool VectorEnvServer::handleRestore(const std::string& args) {
+    // VRESTORE:<* or env indices>:<snapshot slot>. Checked before anything is sent,
+    // so a bad or empty slot never leaves only part of the batch restored
+    size_t pos = args.find(":");
+    std::vector<bool> selected;
+    unsigned int slot;
+    if (!parseTargets(args.substr(0, pos), selected) || !parseSlot(pos == std::string::npos ? "" : args.substr(pos + 1), slot)) {
+        return false;
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        if (selected[i] && !(snapshot_slots_[i] & (1u << slot))) {
+            std::cerr << "[VectorEnvServer] Snapshot slot " << slot << " of environment " << i << " is empty" << std::endl;
+            return false;
+        }
+    }
+    std::string request = "RESTORE:" + std::to_string(slot);
+    return exchange(selected, [&](size_t) { return zmq::buffer(request); });
+}
+
+void VectorEnvServer::sendBatch(uint16_t flags) {
+    ObservationHeader header;
+    header.magic = OBSERVATION_MAGIC;
+    header.version = OBSERVATION_VERSION;
+    header.sequence = ++reply_sequence_;
+    header.count = static_cast<uint32_t>(observations_.size());
+    header.sim_time = sim_time_;    // clock of environment 0
+
+    // After the observation matrix: num_envs x [reward, terminated, truncated], then on resets
+    // <uint32 length><JSON array> with the sampled reset of every environment (null if none)
+    trailer_.clear();
+    if (outcome_) {
+        trailer_.append(reinterpret_cast<const char*>(outcomes_.data()), outcomes_.size() * sizeof(float));
+    }
+    bool reset_info = false;
+    if (flags & OBS_FLAG_RESET) {
+        nlohmann::json infos = nlohmann::json::array();
+        for (std::string& info : reset_info_) {
+            nlohmann::json parsed = info.empty() ? nlohmann::json() : nlohmann::json::parse(info, nullptr, false);
+            infos.push_back(parsed.is_discarded() ? nlohmann::json() : parsed);
+            reset_info = reset_info || !info.empty();
+            info.clear();
+        }
+        if (reset_info) {
+            std::string json = infos.dump();
+            uint32_t length = static_cast<uint32_t>(json.size());
+            trailer_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            trailer_.append(json);
+        }
+    }
+    header.flags = flags | OBS_FLAG_BATCH | (outcome_ ? OBS_FLAG_OUTCOME : 0) | (reset_info ? OBS_FLAG_RESET_INFO : 0);
+    communicator_.sendObservationFrame(header, observations_.data(), observations_.size(), trailer_.data(), trailer_.size());
+}
@@ -0,0 +1,127 @@
+#include "WorldSnapshot.h"
+#include <iostream>
+
+void WorldSnapshot::clear() {
+    valid_ = false;
+    rigid_bodies_.clear();
+    multibodies_.clear();
+    thrusters_.clear();
+    servos_.clear();
+    sensors_.clear();
+}
+
+void WorldSnapshot::capture(sf::SimulationManager* sim) {
+    clear();
+    btMultiBodyDynamicsWorld* world = sim->getDynamicsWorld();
+
+    // Free rigid bodies (multibody links are btMultiBodyLinkCollider and are skipped by upcast)
+    btAlignedObjectArray<btCollisionObject*>& objects = world->getCollisionObjectArray();
+    for (int i = 0; i < objects.size(); ++i) {
+        btRigidBody* body = btRigidBody::upcast(objects[i]);
+        if (!body || body->isStaticOrKinematicObject()) continue;
+        rigid_bodies_.push_back({body, body->getWorldTransform(), 
+                                 body->getLinearVelocity(), body->getAngularVelocity()});
+    }
+
+    for (int i = 0; i < world->getNumMultibodies(); ++i) {
+        btMultiBody* mb = world->getMultiBody(i);
+        MultiBodyState state;
+        state.body = mb;
+        state.base_transform = mb->getBaseWorldTransform();
+        state.base_velocity = mb->getBaseVel();
+        state.base_omega = mb->getBaseOmega();
+        state.q.reserve(mb->getNumPosVars());
+        state.qd.reserve(mb->getNumDofs());
+        for (int l = 0; l < mb->getNumLinks(); ++l) {
+            const btMultibodyLink& link = mb->getLink(l);
+            const btScalar* q = mb->getJointPosMultiDof(l);
+            const btScalar* qd = mb->getJointVelMultiDof(l);
+            state.q.insert(state.q.end(), q, q + link.m_posVarCount);
+            state.qd.insert(state.qd.end(), qd, qd + link.m_dofCount);
+        }
+        multibodies_.push_back(std::move(state));
+    }
+
+    unsigned int id = 0;
+    sf::Actuator* actuator;
+    while ((actuator = sim->getActuator(id++)) != nullptr) {
+        if (sf::Thruster* thruster = dynamic_cast<sf::Thruster*>(actuator)) {
+            thrusters_.push_back({thruster, thruster->getSetpoint()});
+        } else if (sf::Servo* servo = dynamic_cast<sf::Servo*>(actuator)) {
+            servos_.push_back({servo, servo->getPosition()});
+        }
+    }
+
+    id = 0;
+    sf::Sensor* sensor;
+    while ((sensor = sim->getSensor(id++)) != nullptr) {
+        sensors_.push_back(sensor);
+    }
+
+    valid_ = true;
+    std::cout << "[WorldSnapshot] Captured " << rigid_bodies_.size() << " rigid bodies, " 
+              << multibodies_.size() << " multibodies, " << thrusters_.size() << " thrusters, " 
+              << servos_.size() << " servos" << std::endl;
+}
+
+void WorldSnapshot::restore(sf::SimulationManager* sim) {
+    if (!valid_) return;
+    btMultiBodyDynamicsWorld* world = sim->getDynamicsWorld();
+
+    for (const auto& state : rigid_bodies_) {
+        btRigidBody* body = state.body;
+        body->setWorldTransform(state.transform);
+        body->setInterpolationWorldTransform(state.transform);
+        if (body->getMotionState()) {
+            body->getMotionState()->setWorldTransform(state.transform);
+        }
+        body->setLinearVelocity(state.linear_velocity);
+        body->setAngularVelocity(state.angular_velocity);
+        body->setInterpolationLinearVelocity(state.linear_velocity);
+        body->setInterpolationAngularVelocity(state.angular_velocity);
+        body->clearForces();
+        body->activate(true);
+    }
+
+    for (auto& state : multibodies_) {
+        btMultiBody* mb = state.body;
+        mb->setBaseWorldTransform(state.base_transform);
+        mb->setBaseVel(state.base_velocity);
+        mb->setBaseOmega(state.base_omega);
+        size_t qi = 0, di = 0;
+        for (int l = 0; l < mb->getNumLinks(); ++l) {
+            const btMultibodyLink& link = mb->getLink(l);
+            if (link.m_posVarCount > 0) mb->setJointPosMultiDof(l, &state.q[qi]);
+            if (link.m_dofCount > 0) mb->setJointVelMultiDof(l, &state.qd[di]);
+            qi += link.m_posVarCount;
+            di += link.m_dofCount;
+        }
+        mb->clearForcesAndTorques();
+        mb->clearConstraintForces();
+        // Move the link colliders to the restored joint state
+        mb->forwardKinematics(scratch_q_, scratch_m_);
+        mb->updateCollisionObjectWorldTransforms(scratch_q_, scratch_m_);
+    }
+
+    // Drop cached contacts, otherwise the solver warm-starts from the pre-restore manifolds
+    btAlignedObjectArray<btCollisionObject*>& objects = world->getCollisionObjectArray();
+    btOverlappingPairCache* pairs = world->getBroadphase()->getOverlappingPairCache();
+    for (int i = 0; i < objects.size(); ++i) {
+        if (objects[i]->getBroadphaseHandle()) {
+            pairs->cleanProxyFromPairs(objects[i]->getBroadphaseHandle(), world->getDispatcher());
+        }
+    }
+
+    for (const auto& state : thrusters_) {
+        state.thruster->setSetpoint(state.setpoint);
+    }
+    for (const auto& state : servos_) {
+        // Hold the restored joint position until the next action arrives
+        state.servo->setDesiredPosition(state.position);
+        state.servo->setDesiredVelocity(0);
+    }
+    // Sensor histories start over, Reset() takes a fresh sample of the restored state
+    for (sf::Sensor* sensor : sensors_) {
+        sensor->Reset();
+    }
+}
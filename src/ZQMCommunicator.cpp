@@ -2,25 +2,50 @@
 #include <iostream>
 #include <sstream>
 
-#ifdef _WIN32
-    #include <windows.h>
-#else
-    #include <unistd.h>
-#endif
+static bool isInproc(const std::string& address) {
+    return address.compare(0, 9, "inproc://") == 0;
+}
 
-ZMQCommunicator::ZMQCommunicator(const std::string& address) 
-    : context(1), socket(context, ZMQ_REP) {
-    
-    socket.bind(address);
-    std::cout << "[ZMQ] Communicator bound to: " << address << std::endl;
+// "tcp://host:0" is accepted as an alias of ZMQ's "tcp://host:*" (free port)
+static std::string normalizeAddress(const std::string& address) {
+    if (address.compare(0, 6, "tcp://") == 0 && address.size() > 2 
+        && address.compare(address.size() - 2, 2, ":0") == 0) {
+        return address.substr(0, address.size() - 1) + "*";
+    }
+    return address;
+}
+
+zmq::context_t& ZMQCommunicator::sharedContext() {
+    static zmq::context_t shared(1);
+    return shared;
+}
+
+ZMQCommunicator::ZMQCommunicator(const std::string& address, SocketMode mode) 
+    : context(1), 
+      socket(isInproc(address) ? sharedContext() : context, mode == SocketMode::ROUTER ? ZMQ_ROUTER : ZMQ_REP),
+      mode_(mode) {
     
-    #ifdef _WIN32
-        Sleep(1000);
-    #else
-        sleep(1);
-    #endif
+    try {
+        socket.bind(normalizeAddress(address));
+        endpoint_ = socket.get(zmq::sockopt::last_endpoint);
+    } catch (const zmq::error_t& e) {
+        std::cerr << "[ZMQ] ERROR: Cannot bind to " << address << ": " << e.what() << std::endl;
+        return;
+    }
     
-    std::cout << "[ZMQ] Communicator ready!" << std::endl;
+    // No settle delay: clients wait for the HELLO handshake instead
+    std::cout << "[ZMQ] Communicator bound to: " << endpoint_ 
+              << (mode_ == SocketMode::ROUTER ? " (ROUTER, pipelined requests)" : "") << std::endl;
+}
+
+void ZMQCommunicator::sendEnvelope() {
+    if (mode_ != SocketMode::ROUTER) return;
+    zmq::message_t id_msg(peer_id_.data(), peer_id_.size());
+    socket.send(id_msg, zmq::send_flags::sndmore);
+    if (peer_delimiter_) {
+        zmq::message_t delimiter;
+        socket.send(delimiter, zmq::send_flags::sndmore);
+    }
 }
 
 // Template implementation for simple types
@@ -36,6 +61,7 @@ void ZMQCommunicator::send(const std::string& title, const T& data, int id) {
     zmq::message_t data_msg(sizeof(data));
     memcpy(data_msg.data(), &data, sizeof(data));
     
+    sendEnvelope();
     socket.send(id_msg, zmq::send_flags::sndmore);
     socket.send(title_msg, zmq::send_flags::sndmore);
     socket.send(data_msg, zmq::send_flags::none);
@@ -60,6 +86,7 @@ void ZMQCommunicator::send(const std::string& title, const std::vector<float>& d
     zmq::message_t data_msg(data.size() * sizeof(float));
     memcpy(data_msg.data(), data.data(), data.size() * sizeof(float));
     
+    sendEnvelope();
     socket.send(id_msg, zmq::send_flags::sndmore);
     socket.send(title_msg, zmq::send_flags::sndmore);
     socket.send(data_msg, zmq::send_flags::none);
@@ -78,6 +105,7 @@ void ZMQCommunicator::send(const std::string& title, const std::vector<int>& dat
     zmq::message_t data_msg(data.size() * sizeof(int));
     memcpy(data_msg.data(), data.data(), data.size() * sizeof(int));
     
+    sendEnvelope();
     socket.send(id_msg, zmq::send_flags::sndmore);
     socket.send(title_msg, zmq::send_flags::sndmore);
     socket.send(data_msg, zmq::send_flags::none);
@@ -96,6 +124,7 @@ void ZMQCommunicator::send(const std::string& title, const std::vector<double>&
     zmq::message_t data_msg(data.size() * sizeof(double));
     memcpy(data_msg.data(), data.data(), data.size() * sizeof(double));
     
+    sendEnvelope();
     socket.send(id_msg, zmq::send_flags::sndmore);
     socket.send(title_msg, zmq::send_flags::sndmore);
     socket.send(data_msg, zmq::send_flags::none);
@@ -124,6 +153,7 @@ void ZMQCommunicator::send(const std::string& title, const std::vector<std::stri
     zmq::message_t data_msg(serialized.size());
     memcpy(data_msg.data(), serialized.c_str(), serialized.size());
     
+    sendEnvelope();
     socket.send(id_msg, zmq::send_flags::sndmore);
     socket.send(title_msg, zmq::send_flags::sndmore);
     socket.send(data_msg, zmq::send_flags::none);
@@ -135,35 +165,86 @@ void ZMQCommunicator::send(const std::string& title, const std::vector<std::stri
 void ZMQCommunicator::sendJson(const std::string& json_str) {
     zmq::message_t msg(json_str.size());
     memcpy(msg.data(), json_str.c_str(), json_str.size());
+    sendEnvelope();
     socket.send(msg, zmq::send_flags::none);
     // debug output
     // std::cout << "[ZMQ] Sent JSON: " << json_str.length() << " bytes" << std::endl;
 }
 
+// Send binary observation frame without copying it into ZMQ. The trailer (outcome values,
+// reset info) goes right after the observations, outside the header count
+void ZMQCommunicator::sendObservationFrame(const ObservationHeader& header, const float* values, size_t count,
+                                           const void* trailer, size_t trailer_size) {
+    const size_t payload = count * sizeof(float);
+    if (!trailer) trailer_size = 0;
+    const size_t size = sizeof(ObservationHeader) + payload + trailer_size;
+
+    sendEnvelope();
+    FrameBuffer& frame = frame_buffers_[next_frame_];
+    next_frame_ = 1 - next_frame_;
+
+    if (frame.in_flight.load(std::memory_order_acquire)) {
+        // ZMQ still holds this buffer, fall back to a copied message
+        zmq::message_t msg(size);
+        char* data = static_cast<char*>(msg.data());
+        memcpy(data, &header, sizeof(ObservationHeader));
+        memcpy(data + sizeof(ObservationHeader), values, payload);
+        if (trailer_size > 0) {
+            memcpy(data + sizeof(ObservationHeader) + payload, trailer, trailer_size);
+        }
+        socket.send(msg, zmq::send_flags::none);
+        return;
+    }
+
+    if (frame.data.size() < size) {
+        frame.data.resize(size);
+    }
+    memcpy(frame.data.data(), &header, sizeof(ObservationHeader));
+    memcpy(frame.data.data() + sizeof(ObservationHeader), values, payload);
+    if (trailer_size > 0) {
+        memcpy(frame.data.data() + sizeof(ObservationHeader) + payload, trailer, trailer_size);
+    }
+
+    frame.in_flight.store(true, std::memory_order_release);
+    zmq::message_t msg(frame.data.data(), size, &ZMQCommunicator::releaseFrame, &frame.in_flight);
+    socket.send(msg, zmq::send_flags::none);
+}
+
+void ZMQCommunicator::releaseFrame(void* /*data*/, void* hint) {
+    static_cast<std::atomic<bool>*>(hint)->store(false, std::memory_order_release);
+}
+
 // Receive message
 zmq::message_t ZMQCommunicator::receive() {
     zmq::message_t msg;
-    
-    try {
-        auto result = socket.recv(msg, zmq::recv_flags::none);
-        
-        if (!result) {
-            std::cerr << "[ZMQ] Receive failed - no message received" << std::endl;
-            return zmq::message_t(0);
-        }
-        // debug output
-        // std::cout << "[ZMQ] Received: " << msg.size() << " bytes" << std::endl;
-        return msg;
-        
-    } catch (const zmq::error_t& e) {
-        std::cerr << "[ZMQ] Error receiving message: " << e.what() << std::endl;
+    if (!receive(msg, zmq::recv_flags::none)) {
+        std::cerr << "[ZMQ] Receive failed - no message received" << std::endl;
         return zmq::message_t(0);
     }
+    return msg;
 }
 
 // Receive with flags
 bool ZMQCommunicator::receive(zmq::message_t& msg, zmq::recv_flags flags) {
     try {
+        if (mode_ == SocketMode::ROUTER) {
+            // [routing id][empty delimiter, REQ clients only][request]
+            zmq::message_t id_msg;
+            if (!socket.recv(id_msg, flags)) {
+                return false;
+            }
+            peer_id_.assign(static_cast<const char*>(id_msg.data()), id_msg.size());
+            peer_delimiter_ = false;
+            if (!socket.recv(msg, zmq::recv_flags::none)) {
+                return false;
+            }
+            if (msg.size() == 0 && msg.more()) {
+                peer_delimiter_ = true;
+                return static_cast<bool>(socket.recv(msg, zmq::recv_flags::none));
+            }
+            return true;
+        }
+        
         auto result = socket.recv(msg, flags);
         
         if (result) {
@@ -0,0 +1,36 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+// Fixture of the unit tests in tests/: check() counts the failed checks, runTests() runs the
+// test functions and turns the count into the exit code ctest reads
+
+namespace testutil {
+
+inline std::string test_name = "test";
+inline int failures = 0;
+
+inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "[" << test_name << "] FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+inline int runTests(const std::string& name, std::initializer_list<void (*)()> tests) {
+    test_name = name;
+    for (auto test : tests) test();
+    if (failures > 0) {
+        std::cerr << "[" << test_name << "] " << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[" << test_name << "] All checks passed" << std::endl;
+    return 0;
+}
+
+}  // namespace testutil
+
+#endif // TESTUTIL_H
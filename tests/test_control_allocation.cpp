@@ -0,0 +1,164 @@
+#include "ControlPipeline.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <vector>
+
+// Wrench controller allocation (ControlPipeline::solveAllocation), no scene needed
+
+namespace {
+
+using testutil::check;
+
+bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-9;
+}
+
+struct Thruster {
+    double position[3];
+    double direction[3];   // unit vector
+};
+
+// B (6 x n) built like ControlPipeline::compileWrench
+std::vector<double> geometry(const std::vector<Thruster>& thrusters) {
+    size_t n = thrusters.size();
+    std::vector<double> b(6 * n, 0.0);
+    for (size_t j = 0; j < n; ++j) {
+        const double* r = thrusters[j].position;
+        const double* d = thrusters[j].direction;
+        b[0 * n + j] = d[0];
+        b[1 * n + j] = d[1];
+        b[2 * n + j] = d[2];
+        b[3 * n + j] = r[1] * d[2] - r[2] * d[1];
+        b[4 * n + j] = r[2] * d[0] - r[0] * d[2];
+        b[5 * n + j] = r[0] * d[1] - r[1] * d[0];
+    }
+    return b;
+}
+
+// Thrusts u = T w
+std::vector<double> allocate(const std::vector<double>& t, size_t n, const double* wrench) {
+    std::vector<double> u(n, 0.0);
+    for (size_t j = 0; j < n; ++j)
+        for (size_t c = 0; c < 6; ++c) u[j] += t[j * 6 + c] * wrench[c];
+    return u;
+}
+
+// Wrench B u produced by the thrusts
+std::vector<double> produce(const std::vector<double>& b, size_t n, const std::vector<double>& u) {
+    std::vector<double> w(6, 0.0);
+    for (size_t r = 0; r < 6; ++r)
+        for (size_t j = 0; j < n; ++j) w[r] += b[r * n + j] * u[j];
+    return w;
+}
+
+double dot(const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+const double A = 0.4;   // thruster arm along x [m]
+const double W = 0.25;  // thruster arm along y [m]
+
+// Surge pair, sway pair and four vertical thrusters: 8 thrusters spanning all 6 DOF
+std::vector<Thruster> overActuated() {
+    return {
+        {{0, W, 0}, {1, 0, 0}}, {{0, -W, 0}, {1, 0, 0}},
+        {{A, 0, 0}, {0, 1, 0}}, {{-A, 0, 0}, {0, 1, 0}},
+        {{A, W, 0}, {0, 0, 1}}, {{A, -W, 0}, {0, 0, 1}}, {{-A, W, 0}, {0, 0, 1}}, {{-A, -W, 0}, {0, 0, 1}}
+    };
+}
+
+void testExactlyActuated() {
+    // One thruster per DOF: allocation is the exact inverse, T B = I
+    std::vector<Thruster> thrusters = {
+        {{0, W, 0}, {1, 0, 0}}, {{0, -W, 0}, {1, 0, 0}},
+        {{A, 0, 0}, {0, 1, 0}},
+        {{A, W, 0}, {0, 0, 1}}, {{A, -W, 0}, {0, 0, 1}}, {{-A, 0, 0}, {0, 0, 1}}
+    };
+    size_t n = thrusters.size();
+    std::vector<double> b = geometry(thrusters);
+    std::vector<double> t;
+    check(ControlPipeline::solveAllocation(b, n, t), "6 thrusters spanning 6 DOF are solvable");
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = 0; k < n; ++k) {
+            double tb = 0.0;
+            for (size_t c = 0; c < 6; ++c) tb += t[i * 6 + c] * b[c * n + k];
+            check(near(tb, i == k ? 1.0 : 0.0), "T B = I with 6 thrusters");
+        }
+    }
+}
+
+void testOverActuated() {
+    std::vector<Thruster> thrusters = overActuated();
+    size_t n = thrusters.size();
+    std::vector<double> b = geometry(thrusters);
+    std::vector<double> t;
+    check(ControlPipeline::solveAllocation(b, n, t), "8 thrusters spanning 6 DOF are solvable");
+
+    const double wrench[6] = {12.0, -3.0, 5.0, 0.7, -1.1, 2.5};
+    std::vector<double> u = allocate(t, n, wrench);
+    std::vector<double> produced = produce(b, n, u);
+    for (size_t c = 0; c < 6; ++c) {
+        check(near(produced[c], wrench[c]), "8 thrusters produce the requested wrench");
+    }
+
+    // Minimum norm: no component along the null space (thrusts that cancel each other)
+    std::vector<double> horizontal_null = {1, -1, W / A, -W / A, 0, 0, 0, 0};
+    std::vector<double> vertical_null = {0, 0, 0, 0, 1, -1, -1, 1};
+    check(near(dot(produce(b, n, horizontal_null), produce(b, n, horizontal_null)), 0.0), "horizontal null vector");
+    check(near(dot(produce(b, n, vertical_null), produce(b, n, vertical_null)), 0.0), "vertical null vector");
+    check(near(dot(u, horizontal_null), 0.0), "8 thrusters: minimum norm (horizontal)");
+    check(near(dot(u, vertical_null), 0.0), "8 thrusters: minimum norm (vertical)");
+}
+
+void testUnderActuated() {
+    // Horizontal thrusters only: heave, roll and pitch cannot be produced
+    std::vector<Thruster> all = overActuated();
+    std::vector<Thruster> thrusters(all.begin(), all.begin() + 3);   // surge pair and one sway thruster
+    size_t n = thrusters.size();
+    std::vector<double> b = geometry(thrusters);
+    std::vector<double> t;
+    check(ControlPipeline::solveAllocation(b, n, t), "3 independent thrusters are solvable");
+
+    const double wrench[6] = {4.0, 1.5, 9.0, 0.3, -0.2, -0.8};
+    std::vector<double> u = allocate(t, n, wrench);
+    std::vector<double> produced = produce(b, n, u);
+    check(near(produced[0], wrench[0]) && near(produced[1], wrench[1]) && near(produced[5], wrench[5]),
+          "3 thrusters produce the reachable surge, sway and yaw");
+    check(near(produced[2], 0.0) && near(produced[3], 0.0) && near(produced[4], 0.0),
+          "3 thrusters ignore the unreachable heave, roll and pitch");
+
+    // Least squares: the residual is orthogonal to every thruster column
+    for (size_t j = 0; j < n; ++j) {
+        double projection = 0.0;
+        for (size_t c = 0; c < 6; ++c) projection += b[c * n + j] * (produced[c] - wrench[c]);
+        check(near(projection, 0.0), "3 thrusters: residual orthogonal to B");
+    }
+}
+
+void testRankDeficient() {
+    std::vector<double> t;
+    std::vector<Thruster> duplicated = {{{0, W, 0}, {1, 0, 0}}, {{0, W, 0}, {1, 0, 0}}};
+    check(!ControlPipeline::solveAllocation(geometry(duplicated), duplicated.size(), t),
+          "identical thrusters are rejected");
+
+    // 7 thrusters that never push along z do not span 6 DOF
+    std::vector<Thruster> planar;
+    for (int j = 0; j < 7; ++j) {
+        double angle = j * 0.9;
+        planar.push_back({{A * std::cos(angle), W * std::sin(angle), 0}, {std::cos(angle), std::sin(angle), 0}});
+    }
+    check(!ControlPipeline::solveAllocation(geometry(planar), planar.size(), t), "planar thrusters are rejected");
+}
+
+}  // namespace
+
+int main() {
+    return testutil::runTests("test_control_allocation", {
+        testExactlyActuated,
+        testOverActuated,
+        testUnderActuated,
+        testRankDeficient
+    });
+}
@@ -0,0 +1,105 @@
+#include "HistoryRing.h"
+#include "TestUtil.h"
+#include <string>
+#include <vector>
+
+// Frame stacking ring of StateManager (HistoryRing): ordering across the wraparound and resets
+
+namespace {
+
+using testutil::check;
+
+// Frame k of the test: observations {k, k + 0.5}, action {-k}
+const std::vector<float>& pushFrame(HistoryRing& ring, float k, bool reset, bool with_action = true) {
+    float observation[2] = {k, k + 0.5f};
+    float action[1] = {-k};
+    return ring.push(observation, 2, action, with_action ? 1 : 0, reset);
+}
+
+// Frame `index` of a block of 3-float frames holds step k
+bool holds(const std::vector<float>& block, size_t index, float k, float action) {
+    return block[index * 3] == k && block[index * 3 + 1] == k + 0.5f && block[index * 3 + 2] == action;
+}
+
+void testFirstFrameFillsHistory() {
+    HistoryRing ring;
+    ring.resize(4, 3);
+    check(ring.getBlockSize() == 12, "block holds length x frame values");
+    const std::vector<float>& block = pushFrame(ring, 1.0f, true, false);
+    for (size_t i = 0; i < 4; ++i) {
+        check(holds(block, i, 1.0f, 0.0f), "reset frame stands in for the whole history");
+    }
+}
+
+void testWraparound() {
+    HistoryRing ring;
+    ring.resize(3, 3);
+    pushFrame(ring, 0.0f, true, false);
+    // Steps 1..7 wrap the 3 frame ring twice, the block must stay oldest first
+    for (int step = 1; step <= 7; ++step) {
+        const std::vector<float>& block = pushFrame(ring, static_cast<float>(step), false);
+        for (int lag = 2; lag >= 0; --lag) {
+            int k = step - lag;
+            float expected = k < 0 ? 0.0f : static_cast<float>(k);
+            float action = k <= 0 ? 0.0f : -expected;
+            check(holds(block, static_cast<size_t>(2 - lag), expected, action),
+                  "step " + std::to_string(step) + ": frame " + std::to_string(2 - lag) + " is step " + std::to_string(k));
+        }
+    }
+}
+
+void testResetMidEpisode() {
+    HistoryRing ring;
+    ring.resize(3, 3);
+    pushFrame(ring, 0.0f, true, false);
+    pushFrame(ring, 1.0f, false);
+    pushFrame(ring, 2.0f, false);
+    pushFrame(ring, 3.0f, false);   // head is not at slot 0 any more
+    const std::vector<float>& block = pushFrame(ring, 10.0f, true, false);
+    for (size_t i = 0; i < 3; ++i) {
+        check(holds(block, i, 10.0f, 0.0f), "reset drops the previous episode");
+    }
+    const std::vector<float>& next = pushFrame(ring, 11.0f, false);
+    check(holds(next, 0, 10.0f, 0.0f) && holds(next, 1, 10.0f, 0.0f) && holds(next, 2, 11.0f, -11.0f),
+          "first step after a reset keeps the reset frame as history");
+}
+
+void testClear() {
+    HistoryRing ring;
+    ring.resize(2, 3);
+    pushFrame(ring, 1.0f, true, false);
+    pushFrame(ring, 2.0f, false);
+    ring.clear();
+    const std::vector<float>& block = pushFrame(ring, 5.0f, false);
+    check(holds(block, 0, 5.0f, -5.0f) && holds(block, 1, 5.0f, -5.0f), "clear() restarts the history");
+}
+
+void testFrameBounds() {
+    // More actions than the frame has room for are cut, missing values are zero
+    HistoryRing ring;
+    ring.resize(2, 3);
+    float observation[2] = {1.0f, 2.0f};
+    float actions[3] = {7.0f, 8.0f, 9.0f};
+    const std::vector<float>& block = ring.push(observation, 2, actions, 3, true);
+    check(block.size() == 6 && block[2] == 7.0f && block[5] == 7.0f, "actions are cut at the frame size");
+    const std::vector<float>& shorter = ring.push(observation, 1, actions, 0, false);
+    check(shorter[3] == 1.0f && shorter[4] == 0.0f && shorter[5] == 0.0f, "missing values are zero");
+
+    HistoryRing single;
+    single.resize(0, 3);
+    check(single.getLength() == 1, "length is at least one frame");
+    check(holds(pushFrame(single, 4.0f, false), 0, 4.0f, -4.0f), "one frame ring returns the current frame");
+    check(holds(pushFrame(single, 5.0f, false), 0, 5.0f, -5.0f), "one frame ring wraps onto itself");
+}
+
+}  // namespace
+
+int main() {
+    return testutil::runTests("test_history_ring", {
+        testFirstFrameFillsHistory,
+        testWraparound,
+        testResetMidEpisode,
+        testClear,
+        testFrameBounds
+    });
+}
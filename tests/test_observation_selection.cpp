@@ -0,0 +1,73 @@
+#include "ObservationSelection.h"
+#include "TestUtil.h"
+#include <vector>
+
+// Reply of a CMD observation filter (ObservationSelection): length and values across filters
+
+namespace {
+
+using testutil::check;
+
+using Ranges = std::vector<ObservationSelection::Range>;
+
+// Full vector 0, 1, ..., n - 1: every value names its own offset
+std::vector<float> fullVector(size_t n) {
+    std::vector<float> full(n);
+    for (size_t i = 0; i < n; ++i) full[i] = static_cast<float>(i);
+    return full;
+}
+
+bool holds(const std::vector<float>& reply, const std::vector<float>& expected) {
+    return reply == expected;
+}
+
+void testAddRange() {
+    Ranges ranges;
+    ObservationSelection::addRange(ranges, 0, 3);
+    ObservationSelection::addRange(ranges, 3, 2);   // adjacent: merged
+    ObservationSelection::addRange(ranges, 7, 1);
+    check(ranges.size() == 2, "adjacent ranges are merged");
+    check(ranges[0].offset == 0 && ranges[0].count == 5, "merged range covers both specs");
+    check(ranges[1].offset == 7 && ranges[1].count == 1, "gap starts a new range");
+}
+
+void testWideThenNarrow() {
+    std::vector<float> full = fullVector(16);
+    ObservationSelection selection;
+    const std::vector<float>& wide = selection.gather({{0, 4}, {6, 8}}, full.data());
+    check(wide.size() == 12, "wide filter reply holds 12 values");
+    check(holds(wide, {0, 1, 2, 3, 6, 7, 8, 9, 10, 11, 12, 13}), "wide filter values");
+
+    full[9] = -9.0f;
+    const std::vector<float>& narrow = selection.gather({{9, 1}, {15, 1}}, full.data());
+    check(narrow.size() == 2, "narrow filter after a wide one holds only its 2 values");
+    check(holds(narrow, {-9.0f, 15.0f}), "narrow filter values, no tail of the wide reply");
+
+    const std::vector<float>& wide_again = selection.gather({{0, 16}}, full.data());
+    check(wide_again.size() == 16 && wide_again[9] == -9.0f && wide_again[15] == 15.0f, "wide filter again");
+}
+
+void testWrittenSelection() {
+    // Filters read straight from the scene: the caller writes begin(count) values
+    ObservationSelection selection;
+    float* out = selection.begin(5);
+    for (int i = 0; i < 5; ++i) out[i] = 1.0f;
+    out = selection.begin(2);
+    out[0] = 4.0f;
+    out[1] = 5.0f;
+    check(selection.get().size() == 2, "written reply is as long as the current filter");
+    check(holds(selection.get(), {4.0f, 5.0f}), "written reply values");
+
+    std::vector<float> full = fullVector(4);
+    check(selection.gather({}, full.data()).empty(), "empty selection gives an empty reply");
+}
+
+}  // namespace
+
+int main() {
+    return testutil::runTests("test_observation_selection", {
+        testAddRange,
+        testWideThenNarrow,
+        testWrittenSelection
+    });
+}
@@ -0,0 +1,89 @@
+#include "SubstepAccumulators.h"
+#include "TestUtil.h"
+#include <cmath>
+
+// Substep aggregates of StateManager (SubstepAccumulators): mean, min, max and integral over an interval
+
+namespace {
+
+using testutil::check;
+
+bool near(float a, float b) {
+    return std::fabs(a - b) < 1e-5f;
+}
+
+void testInterval() {
+    SubstepAccumulators acc;
+    acc.resize(2);
+    check(acc.size() == 2 && acc.getSteps() == 0, "no step after resize");
+    // Two specs over three substeps of 0.1 s
+    const float values[3][2] = {{1.0f, -2.0f}, {4.0f, 0.5f}, {-3.0f, 1.5f}};
+    for (const auto& step : values) acc.add(step, 0.1f);
+    check(acc.getSteps() == 3, "one step per add()");
+    check(near(acc.getMean(0), 2.0f / 3.0f) && near(acc.getMean(1), 0.0f), "mean over the substeps");
+    check(acc.getMin(0) == -3.0f && acc.getMin(1) == -2.0f, "min over the substeps");
+    check(acc.getMax(0) == 4.0f && acc.getMax(1) == 1.5f, "max over the substeps");
+    check(near(acc.getIntegral(0), 0.2f) && near(acc.getIntegral(1), 0.0f), "integral is the sum of value x dt");
+}
+
+void testVariableStep() {
+    SubstepAccumulators acc;
+    acc.resize(1);
+    float a = 2.0f, b = 10.0f;
+    acc.add(&a, 0.5f);
+    acc.add(&b, 0.01f);
+    check(near(acc.getIntegral(0), 1.1f), "integral weights each value by its own dt");
+    check(near(acc.getMean(0), 6.0f), "mean is per step, not per second");
+}
+
+void testReset() {
+    SubstepAccumulators acc;
+    acc.resize(1);
+    float settle = 100.0f;
+    acc.add(&settle, 0.1f);   // post reset settle step
+    acc.reset();
+    check(acc.getSteps() == 0 && acc.getIntegral(0) == 0.0f, "reset empties the interval");
+    float v = -1.0f;
+    acc.add(&v, 0.1f);
+    check(acc.getSteps() == 1, "steps count from the reset");
+    check(acc.getMean(0) == -1.0f && acc.getMin(0) == -1.0f && acc.getMax(0) == -1.0f,
+          "values before the reset leave no trace");
+    check(near(acc.getIntegral(0), -0.1f), "integral restarts at zero");
+
+    // Negative only and positive only intervals: min and max start from the extremes, not from zero
+    float high = 5.0f;
+    acc.reset();
+    acc.add(&high, 0.1f);
+    check(acc.getMin(0) == 5.0f, "min of a positive interval");
+    acc.reset();
+    acc.add(&v, 0.1f);
+    check(acc.getMax(0) == -1.0f, "max of a negative interval");
+}
+
+void testResize() {
+    SubstepAccumulators acc;
+    acc.resize(1);
+    float v = 3.0f;
+    acc.add(&v, 0.1f);
+    acc.resize(3);
+    check(acc.size() == 3 && acc.getSteps() == 0, "resize starts a new interval");
+    float values[3] = {1.0f, 2.0f, 3.0f};
+    acc.add(values, 1.0f);
+    check(acc.getMean(0) == 1.0f && acc.getMean(2) == 3.0f, "values map to their accumulator");
+
+    SubstepAccumulators empty;
+    empty.resize(0);
+    empty.add(nullptr, 0.1f);
+    check(empty.size() == 0 && empty.getSteps() == 1, "no aggregated specs");
+}
+
+}  // namespace
+
+int main() {
+    return testutil::runTests("test_substep_accumulators", {
+        testInterval,
+        testVariableStep,
+        testReset,
+        testResize
+    });
+}